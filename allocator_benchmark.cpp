@@ -0,0 +1,351 @@
+#include "list.cpp"
+#include "unordered_map.cpp"
+#include "fastallocator.cpp"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <functional>
+#include <condition_variable>
+#include <fstream>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+
+struct BenchmarkOptions {
+    size_t operations = 1'000'000;
+    size_t threads = std::max<size_t>(2, std::min<size_t>(8, std::thread::hardware_concurrency()));
+    size_t live_nodes = 10'000;
+    std::string filter = "";
+};
+
+using BenchmarkClock = std::chrono::steady_clock;
+
+const size_t PRODUCER_BATCH_SIZE = 256;
+
+// each worker publishes its result once, so the optimizer cannot drop the workload
+std::atomic<size_t> benchmark_sink(0);
+std::atomic<size_t> peak_rss_kb(0);
+
+size_t current_rss_kb() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+void sample_rss() {
+    size_t rss = current_rss_kb();
+    size_t peak = peak_rss_kb.load();
+    while (rss > peak && !peak_rss_kb.compare_exchange_weak(peak, rss)) {}
+}
+
+class LatencyRecorder {
+  public:
+    void start() {
+        batch_start = BenchmarkClock::now();
+        in_batch = 0;
+    }
+
+    void tick() {
+        if (++in_batch < BATCH_SIZE) return;
+        BenchmarkClock::time_point now = BenchmarkClock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(now - batch_start).count()
+                / BATCH_SIZE);
+        batch_start = now;
+        in_batch = 0;
+    }
+
+    std::vector<double> samples;
+  private:
+    inline static const size_t BATCH_SIZE = 256;
+
+    BenchmarkClock::time_point batch_start;
+    size_t in_batch = 0;
+};
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+void report(const std::string& name, const std::string& allocator, size_t threads,
+        size_t operations, double seconds, std::vector<double> latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    std::cout << name << ',' << allocator << ',' << threads << ',' << operations << ','
+            << operations / seconds / 1e6 << ',' << percentile(latencies, 0.5) << ','
+            << percentile(latencies, 0.99) << ',' << percentile(latencies, 0.999) << ','
+            << peak_rss_kb.load() << std::endl;
+}
+
+void run_threads(const std::string& name, const std::string& allocator, size_t threads,
+        size_t operations, const std::function<void(size_t, LatencyRecorder&)>& body) {
+    std::vector<LatencyRecorder> recorders(threads);
+    std::vector<std::thread> workers;
+    peak_rss_kb = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&body, &recorders, i]() { body(i, recorders[i]); });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+
+    std::vector<double> latencies;
+    for (const LatencyRecorder& recorder : recorders) {
+        latencies.insert(latencies.end(), recorder.samples.begin(), recorder.samples.end());
+    }
+    report(name, allocator, threads, operations * threads, seconds, latencies);
+}
+
+bool selected(const BenchmarkOptions& options, const std::string& name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// *****
+// Allocators
+// *****
+
+struct StdAllocatorKind {
+    inline static const char* NAME = "std";
+    inline static const bool SHARED = true;
+
+    template<typename T>
+    static std::allocator<T> make() {
+        return std::allocator<T>();
+    }
+};
+
+struct FastAllocatorKind {
+    inline static const char* NAME = "fast";
+    inline static const bool SHARED = true;
+
+    template<typename T>
+    static FastAllocator<T> make() {
+        return FastAllocator<T>();
+    }
+};
+
+struct PrivatePoolsKind {
+    inline static const char* NAME = "fast_private";
+    inline static const bool SHARED = false;
+
+    template<typename T>
+    static FastAllocator<T> make() {
+        return FastAllocator<T>(std::make_shared<PrivatePools>());
+    }
+};
+
+struct ArenaAllocatorKind {
+    inline static const char* NAME = "arena";
+    inline static const bool SHARED = false;
+
+    template<typename T>
+    static ArenaAllocator<T> make() {
+        return ArenaAllocator<T>();
+    }
+};
+
+// *****
+// Workloads
+// *****
+
+template<typename Kind>
+void list_churn(const BenchmarkOptions& options, LatencyRecorder& recorder) {
+    auto alloc = Kind::template make<int>();
+    List<int, decltype(alloc)> list(alloc);
+    for (size_t i = 0; i < options.live_nodes; ++i) {
+        list.push_back(static_cast<int>(i));
+    }
+    recorder.start();
+    for (size_t i = 0; i < options.operations; ++i) {
+        list.pop_front();
+        list.push_back(static_cast<int>(i));
+        recorder.tick();
+    }
+    sample_rss();
+    benchmark_sink.fetch_add(list.size(), std::memory_order_relaxed);
+}
+
+template<typename Kind>
+void map_churn(const BenchmarkOptions& options, LatencyRecorder& recorder, size_t seed) {
+    auto alloc = Kind::template make<std::pair<const int, int>>();
+    UnorderedMap<int, int, std::hash<int>, std::equal_to<int>, decltype(alloc)> map(alloc);
+    std::mt19937 generator(seed);
+    int key_range = static_cast<int>(2 * options.live_nodes);
+    for (size_t i = 0; i < options.live_nodes; ++i) {
+        map[generator() % key_range] = static_cast<int>(i);
+    }
+    recorder.start();
+    for (size_t i = 0; i < options.operations; ++i) {
+        int key = generator() % key_range;
+        auto it = map.find(key);
+        if (it != map.end()) {
+            map.erase(it);
+        } else {
+            map[key] = static_cast<int>(i);
+        }
+        recorder.tick();
+    }
+    sample_rss();
+    benchmark_sink.fetch_add(map.size(), std::memory_order_relaxed);
+}
+
+template<typename Kind>
+void random_size_ring(const BenchmarkOptions& options, LatencyRecorder& recorder, size_t seed) {
+    auto alloc = Kind::template make<char>();
+    std::mt19937 generator(seed);
+    std::vector<std::pair<char*, size_t>> ring(options.live_nodes, {nullptr, 0});
+    recorder.start();
+    for (size_t i = 0; i < options.operations; ++i) {
+        std::pair<char*, size_t>& slot = ring[i % ring.size()];
+        if (slot.first != nullptr) {
+            alloc.deallocate(slot.first, slot.second);
+        }
+        slot.second = 8 + generator() % 505;
+        slot.first = alloc.allocate(slot.second);
+        slot.first[0] = static_cast<char>(i);
+        recorder.tick();
+    }
+    sample_rss();
+    for (std::pair<char*, size_t>& slot : ring) {
+        if (slot.first != nullptr) {
+            alloc.deallocate(slot.first, slot.second);
+        }
+    }
+}
+
+template<typename Kind>
+void producer_consumer(const BenchmarkOptions& options, size_t pairs) {
+    struct Channel {
+        std::mutex mutex;
+        std::condition_variable ready;
+        std::vector<std::vector<std::pair<char*, size_t>>> batches;
+        bool done = false;
+    };
+
+    std::vector<Channel> channels(pairs);
+    std::vector<LatencyRecorder> recorders(2 * pairs);
+    std::vector<std::thread> workers;
+    peak_rss_kb = 0;
+    BenchmarkClock::time_point start = BenchmarkClock::now();
+    for (size_t p = 0; p < pairs; ++p) {
+        workers.emplace_back([&options, &channels, &recorders, p]() {
+            auto alloc = Kind::template make<char>();
+            std::mt19937 generator(p);
+            Channel& channel = channels[p];
+            LatencyRecorder& recorder = recorders[2 * p];
+            std::vector<std::pair<char*, size_t>> batch;
+            recorder.start();
+            for (size_t i = 0; i < options.operations; ++i) {
+                size_t size = 8 + generator() % 505;
+                char* ptr = alloc.allocate(size);
+                ptr[0] = static_cast<char>(i);
+                batch.emplace_back(ptr, size);
+                if (batch.size() == PRODUCER_BATCH_SIZE || i + 1 == options.operations) {
+                    std::lock_guard<std::mutex> lock(channel.mutex);
+                    channel.batches.push_back(std::move(batch));
+                    batch.clear();
+                    channel.ready.notify_one();
+                }
+                recorder.tick();
+            }
+            std::lock_guard<std::mutex> lock(channel.mutex);
+            channel.done = true;
+            channel.ready.notify_one();
+        });
+        workers.emplace_back([&channels, &recorders, p]() {
+            auto alloc = Kind::template make<char>();
+            Channel& channel = channels[p];
+            LatencyRecorder& recorder = recorders[2 * p + 1];
+            recorder.start();
+            while (true) {
+                std::vector<std::vector<std::pair<char*, size_t>>> batches;
+                {
+                    std::unique_lock<std::mutex> lock(channel.mutex);
+                    channel.ready.wait(lock, [&channel]() {
+                        return channel.done || !channel.batches.empty();
+                    });
+                    if (channel.batches.empty()) break;
+                    batches.swap(channel.batches);
+                }
+                sample_rss();
+                for (auto& batch : batches) {
+                    for (std::pair<char*, size_t>& block : batch) {
+                        alloc.deallocate(block.first, block.second);
+                        recorder.tick();
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(BenchmarkClock::now() - start).count();
+
+    std::vector<double> latencies;
+    for (const LatencyRecorder& recorder : recorders) {
+        latencies.insert(latencies.end(), recorder.samples.begin(), recorder.samples.end());
+    }
+    report("producer_consumer", Kind::NAME, 2 * pairs, 2 * options.operations * pairs, seconds,
+            latencies);
+}
+
+// *****
+
+template<typename Kind>
+void benchmark_allocator(const BenchmarkOptions& options) {
+    for (size_t threads : {size_t(1), options.threads}) {
+        if (selected(options, "list_churn")) {
+            run_threads("list_churn", Kind::NAME, threads, options.operations,
+                    [&options](size_t, LatencyRecorder& recorder) {
+                list_churn<Kind>(options, recorder);
+            });
+        }
+        if (selected(options, "map_churn")) {
+            run_threads("map_churn", Kind::NAME, threads, options.operations,
+                    [&options](size_t thread, LatencyRecorder& recorder) {
+                map_churn<Kind>(options, recorder, thread);
+            });
+        }
+        if (selected(options, "random_size_ring")) {
+            run_threads("random_size_ring", Kind::NAME, threads, options.operations,
+                    [&options](size_t thread, LatencyRecorder& recorder) {
+                random_size_ring<Kind>(options, recorder, thread);
+            });
+        }
+    }
+    if (Kind::SHARED && selected(options, "producer_consumer")) {
+        producer_consumer<Kind>(options, std::max<size_t>(1, options.threads / 2));
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--operations") && i + 1 < argc) {
+            options.operations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--threads") && i + 1 < argc) {
+            options.threads = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--live-nodes") && i + 1 < argc) {
+            options.live_nodes = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--operations N] [--threads N]"
+                    << " [--live-nodes N] [--filter NAME]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "benchmark,allocator,threads,operations,mops_per_s,p50_ns,p99_ns,p999_ns,peak_rss_kb"
+            << std::endl;
+    benchmark_allocator<StdAllocatorKind>(options);
+    benchmark_allocator<FastAllocatorKind>(options);
+    benchmark_allocator<PrivatePoolsKind>(options);
+    benchmark_allocator<ArenaAllocatorKind>(options);
+    return 0;
+}
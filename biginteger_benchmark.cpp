@@ -0,0 +1,219 @@
+#include "biginteger.cpp"
+
+#include <chrono>
+#include <random>
+#include <sstream>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+
+struct BenchmarkOptions {
+    size_t max_digits = 10'000'000;
+    double min_time = 0.2;
+    size_t max_iterations = 1'000'000;
+    bool full = false;
+    std::string filter = "";
+};
+
+struct BenchmarkCase {
+    std::string name;
+    std::string shape;
+    size_t digits;
+    size_t other_digits;
+};
+
+std::mt19937_64 generator(20200229);
+volatile size_t benchmark_sink = 0;
+
+std::string random_digits(size_t digits) {
+    std::string s(digits, '0');
+    s[0] = static_cast<char>('1' + generator() % 9);
+    for (size_t i = 1; i < digits; ++i) {
+        s[i] = static_cast<char>('0' + generator() % 10);
+    }
+    return s;
+}
+
+BigInteger random_big_integer(size_t digits) {
+    std::istringstream in(random_digits(digits));
+    BigInteger x;
+    in >> x;
+    return x;
+}
+
+void run_case(const BenchmarkOptions& options, const BenchmarkCase& benchmark,
+        const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 0;
+    clock::time_point start = clock::now();
+    double elapsed = 0;
+    while (iterations < options.max_iterations && (iterations == 0 || elapsed < options.min_time)) {
+        body();
+        ++iterations;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+    std::cout << benchmark.name << ',' << benchmark.shape << ',' << benchmark.digits << ','
+            << benchmark.other_digits << ',' << iterations << ','
+            << static_cast<long long>(elapsed * 1e9 / iterations) << std::endl;
+}
+
+bool selected(const BenchmarkOptions& options, const std::string& name, size_t digits,
+        size_t default_limit) {
+    if (digits > options.max_digits) return false;
+    if (!options.full && digits > default_limit) return false;
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+// *****
+// BigInteger
+// *****
+
+void benchmark_binary(const BenchmarkOptions& options, const std::string& name, size_t limit,
+        const std::function<BigInteger(const BigInteger&, const BigInteger&)>& op,
+        const std::vector<size_t>& sizes) {
+    for (size_t digits : sizes) {
+        if (!selected(options, name, digits, limit)) continue;
+        std::vector<std::pair<std::string, size_t>> shapes = {
+            {"balanced", digits},
+            {"unbalanced", std::max<size_t>(1, digits / 16)},
+            {"single_limb", std::min<size_t>(digits, 4)}
+        };
+        for (const auto& shape : shapes) {
+            BigInteger a = random_big_integer(digits);
+            BigInteger b = random_big_integer(shape.second);
+            run_case(options, {name, shape.first, digits, shape.second}, [&]() {
+                BigInteger result = op(a, b);
+                benchmark_sink += static_cast<bool>(result);
+            });
+        }
+    }
+}
+
+void benchmark_division(const BenchmarkOptions& options, const std::string& name, size_t limit,
+        const std::function<BigInteger(const BigInteger&, const BigInteger&)>& op,
+        const std::vector<size_t>& sizes) {
+    for (size_t digits : sizes) {
+        if (!selected(options, name, digits, limit)) continue;
+        std::vector<std::pair<std::string, size_t>> shapes = {
+            {"balanced", std::max<size_t>(1, digits / 2)},
+            {"unbalanced", std::max<size_t>(1, digits - digits / 16)},
+            {"single_limb", std::min<size_t>(digits, 4)}
+        };
+        for (const auto& shape : shapes) {
+            BigInteger a = random_big_integer(digits);
+            BigInteger b = random_big_integer(shape.second);
+            run_case(options, {name, shape.first, digits, shape.second}, [&]() {
+                BigInteger result = op(a, b);
+                benchmark_sink += static_cast<bool>(result);
+            });
+        }
+    }
+}
+
+void benchmark_big_integer(const BenchmarkOptions& options, const std::vector<size_t>& sizes) {
+    benchmark_binary(options, "add", 10'000'000,
+            [](const BigInteger& a, const BigInteger& b) { return a + b; }, sizes);
+    benchmark_binary(options, "sub", 10'000'000,
+            [](const BigInteger& a, const BigInteger& b) { return a - b; }, sizes);
+    benchmark_binary(options, "mul", 1'000'000,
+            [](const BigInteger& a, const BigInteger& b) { return a * b; }, sizes);
+    benchmark_division(options, "div", 10'000,
+            [](const BigInteger& a, const BigInteger& b) { return a / b; }, sizes);
+    benchmark_division(options, "mod", 10'000,
+            [](const BigInteger& a, const BigInteger& b) { return a % b; }, sizes);
+
+    for (size_t digits : sizes) {
+        if (selected(options, "to_string", digits, 10'000'000)) {
+            BigInteger a = random_big_integer(digits);
+            run_case(options, {"to_string", "single", digits, 0}, [&]() {
+                benchmark_sink += a.toString().size();
+            });
+        }
+        if (selected(options, "read", digits, 10'000'000)) {
+            std::string s = random_digits(digits);
+            run_case(options, {"read", "single", digits, 0}, [&]() {
+                std::istringstream in(s);
+                BigInteger x;
+                in >> x;
+                benchmark_sink += static_cast<bool>(x);
+            });
+        }
+    }
+
+    if (selected(options, "mul_threshold", 0, 0)) {
+        for (size_t limbs = 1; limbs <= 64; limbs *= 2) {
+            BigInteger a = random_big_integer(limbs * 4);
+            BigInteger b = random_big_integer(limbs * 4);
+            run_case(options, {"mul_threshold", "balanced", limbs * 4, limbs * 4}, [&]() {
+                BigInteger result = a * b;
+                benchmark_sink += static_cast<bool>(result);
+            });
+        }
+    }
+}
+
+// *****
+// Rational
+// *****
+
+void benchmark_rational(const BenchmarkOptions& options, const std::vector<size_t>& sizes) {
+    for (size_t digits : sizes) {
+        if (selected(options, "rational_normalize", digits, 128)) {
+            BigInteger common = random_big_integer(std::max<size_t>(1, digits / 2));
+            BigInteger a = random_big_integer(digits) * common;
+            BigInteger b = random_big_integer(digits) * common;
+            run_case(options, {"rational_normalize", "common_factor", digits, digits}, [&]() {
+                Rational x = a;
+                x /= b;
+                benchmark_sink += x.toString().size();
+            });
+        }
+        if (selected(options, "rational_as_decimal", digits, 1'000)) {
+            Rational x = random_big_integer(digits);
+            x /= random_big_integer(digits);
+            for (size_t precision : {size_t(10), size_t(100), size_t(1000)}) {
+                run_case(options, {"rational_as_decimal", "precision", digits, precision}, [&]() {
+                    benchmark_sink += x.asDecimal(precision).size();
+                });
+            }
+        }
+        if (selected(options, "rational_double", digits, 1'000)) {
+            Rational x = random_big_integer(digits);
+            x /= random_big_integer(digits);
+            run_case(options, {"rational_double", "single", digits, digits}, [&]() {
+                benchmark_sink += static_cast<size_t>(static_cast<double>(x));
+            });
+        }
+    }
+}
+
+// *****
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--max-digits") && i + 1 < argc) {
+            options.max_digits = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            options.min_time = std::strtod(argv[++i], nullptr);
+        } else if (!strcmp(argv[i], "--max-iterations") && i + 1 < argc) {
+            options.max_iterations = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (!strcmp(argv[i], "--full")) {
+            options.full = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--max-digits N] [--min-time SECONDS]"
+                    << " [--max-iterations N] [--filter NAME] [--full]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<size_t> sizes = {4, 8, 16, 32, 64, 128, 1'000, 10'000, 100'000,
+            1'000'000, 10'000'000};
+
+    std::cout << "benchmark,shape,digits,other_digits,iterations,ns_per_op" << std::endl;
+    benchmark_big_integer(options, sizes);
+    benchmark_rational(options, sizes);
+    return 0;
+}
@@ -1,5 +1,81 @@
+#pragma once
+
 #include "fastallocator.h"
 
+// *****
+// POOL MEMORY
+// *****
+
+#if defined(FAST_ALLOCATOR_MMAP_POOLS) && defined(__linux__)
+
+inline size_t PoolMemory::mapped_size(size_t bytes) {
+    size_t page = bytes >= HUGE_PAGE_SIZE ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE);
+    return (bytes + page - 1) / page * page;
+}
+
+inline void* PoolMemory::allocate(size_t bytes, size_t alignment) {
+    size_t size = mapped_size(bytes);
+    bool huge = size >= HUGE_PAGE_SIZE && huge_pages.load(std::memory_order_relaxed);
+    bool populate = prefault.load(std::memory_order_relaxed);
+    size_t page = sysconf(_SC_PAGESIZE);
+    if (huge) {
+        alignment = std::max(alignment, HUGE_PAGE_SIZE);
+    }
+
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    if (populate && !huge) {
+        flags |= MAP_POPULATE;
+    }
+    size_t reserve = alignment > page ? size + alignment : size;
+    void* region = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (region == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+
+    char* begin = reinterpret_cast<char*>(region);
+    char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(begin) + alignment - 1)
+            / alignment * alignment);
+    if (aligned != begin) {
+        munmap(begin, aligned - begin);
+    }
+    if (aligned + size != begin + reserve) {
+        munmap(aligned + size, begin + reserve - (aligned + size));
+    }
+    if (huge) {
+        madvise(aligned, size, MADV_HUGEPAGE);
+        if (populate) {
+            for (size_t offset = 0; offset < size; offset += page) {
+                aligned[offset] = 0;
+            }
+        }
+    }
+    return aligned;
+}
+
+inline void PoolMemory::deallocate(void* ptr, size_t bytes, size_t) {
+    munmap(ptr, mapped_size(bytes));
+}
+
+#else
+
+inline void* PoolMemory::allocate(size_t bytes, size_t alignment) {
+    return ::operator new(bytes, std::align_val_t(std::max(ALIGNMENT, alignment)));
+}
+
+inline void PoolMemory::deallocate(void* ptr, size_t, size_t alignment) {
+    ::operator delete(ptr, std::align_val_t(std::max(ALIGNMENT, alignment)));
+}
+
+#endif
+
+inline void PoolMemory::set_huge_pages(bool enabled) {
+    huge_pages.store(enabled, std::memory_order_relaxed);
+}
+
+inline void PoolMemory::set_prefault(bool enabled) {
+    prefault.store(enabled, std::memory_order_relaxed);
+}
+
 // *****
 // FIXED ALLOC
 // *****
@@ -11,15 +87,25 @@ FixedAllocator<chunkSize>& FixedAllocator<chunkSize>::get_instance() {
 }
 
 template<size_t chunkSize>
-FixedAllocator<chunkSize>::FixedAllocator(): pools(std::vector<void*>(0)),
-        next_free(std::vector<void*>(0)) {
-    add_pool();
-}
+FixedAllocator<chunkSize>::FixedAllocator(): pools(std::vector<Pool>(0)), current_pool(0),
+        empty_pools(0), next_pool_size(Traits::FIRST_POOL_SIZE),
+        max_pool_size(std::max(Traits::FIRST_POOL_SIZE, Traits::MAX_POOL_BYTES / chunkSize)),
+        pool_growth_factor(Traits::POOL_GROWTH_FACTOR), pool_bytes(0), peak_pool_bytes(0) {}
 
 template<size_t chunkSize>
 FixedAllocator<chunkSize>::~FixedAllocator() {
+#ifdef FAST_ALLOCATOR_STATS
+    size_t live = allocation_count.load() - deallocation_count.load();
+    if (live != 0) {
+        std::cerr << "FixedAllocator<" << chunkSize << ">: " << live
+                << " chunks still live at exit" << std::endl;
+    }
+#endif
     for (size_t i = 0; i < pools.size(); ++i) {
-        ::operator delete[](pools[i], POOL_SIZE);
+        PoolMemory::deallocate(pools[i].begin, pools[i].end - pools[i].begin, SEGMENT_SIZE);
+    }
+    for (size_t i = 0; i < remote_lists.size(); ++i) {
+        delete remote_lists[i];
     }
 }
 
@@ -32,90 +118,1058 @@ bool FixedAllocator<chunkSize>::operator==(const FixedAllocator<anotherSize>& an
 }
 
 template<size_t chunkSize>
-void* FixedAllocator<chunkSize>::allocate() {
-    if (next_free.empty()) {
-        add_pool();
+inline void* FixedAllocator<chunkSize>::allocate() {
+    ThreadCache* local = cache;
+    if (local == nullptr || local->next_free == nullptr) {
+        return allocate_slow();
     }
-    void* ret = next_free.back();
-    next_free.pop_back();
+    void* ret = local->next_free;
+    local->next_free = next_chunk(ret);
+    --local->free_count;
+    record(local, 1, 0);
     return ret;
 }
 
 template<size_t chunkSize>
-void FixedAllocator<chunkSize>::deallocate(void* ptr) {
-    next_free.push_back(ptr);
+inline void FixedAllocator<chunkSize>::deallocate(void* ptr) {
+    ThreadCache* local = cache;
+    if (local == nullptr || local->free_count == CACHE_BATCH_SIZE || is_remote(local, ptr)) {
+        deallocate_slow(ptr);
+        return;
+    }
+    next_chunk(ptr) = local->next_free;
+    local->next_free = ptr;
+    ++local->free_count;
+    record(local, 0, 1);
+}
+
+template<size_t chunkSize>
+void* FixedAllocator<chunkSize>::allocate_slow() {
+    ThreadCache* local = get_cache();
+    if (local == nullptr) {
+        record(nullptr, 1, 0);
+        std::lock_guard<std::mutex> lock(mutex);
+        return take_chunks(1, nullptr, false);
+    }
+    if (local->next_free == nullptr) {
+        refill(*local);
+    }
+    return allocate();
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::deallocate_slow(void* ptr) {
+    ThreadCache* local = get_cache();
+    if (local == nullptr) {
+        record(nullptr, 0, 1);
+        next_chunk(ptr) = nullptr;
+        release(ptr);
+        return;
+    }
+    if (is_remote(local, ptr)) {
+        record(local, 0, 1);
+        push_remote(*local, ptr);
+        return;
+    }
+    if (local->free_count == CACHE_BATCH_SIZE) {
+        flush(*local);
+    }
+    deallocate(ptr);
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::allocate_bulk(size_t count, void** out, bool contiguous) {
+    ThreadCache* local = cache != nullptr ? cache : get_cache();
+    record(local, count, 0);
+    size_t i = 0;
+    if (local != nullptr && !contiguous) {
+        for ( ; i < count && local->next_free != nullptr; ++i) {
+            out[i] = local->next_free;
+            local->next_free = next_chunk(out[i]);
+            --local->free_count;
+        }
+    }
+    if (i == count) return;
+
+    void* first;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        first = take_chunks(count - i, local != nullptr ? local->remote : nullptr, contiguous);
+    }
+    for ( ; i < count; ++i) {
+        out[i] = first;
+        first = next_chunk(first);
+    }
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::deallocate_bulk(void** ptrs, size_t count) {
+    ThreadCache* local = cache != nullptr ? cache : get_cache();
+    record(local, 0, count);
+    void* overflow = nullptr;
+    for (size_t i = count; i > 0; ) {
+        void* ptr = ptrs[--i];
+        if (local != nullptr && is_remote(local, ptr)) {
+            push_remote(*local, ptr);
+        } else if (local != nullptr && local->free_count < CACHE_BATCH_SIZE) {
+            next_chunk(ptr) = local->next_free;
+            local->next_free = ptr;
+            ++local->free_count;
+        } else {
+            next_chunk(ptr) = overflow;
+            overflow = ptr;
+        }
+    }
+    if (overflow != nullptr) {
+        release(overflow);
+    }
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::set_pool_sizes(size_t first_pool_size, size_t max_pool_size,
+        size_t growth_factor) {
+    std::lock_guard<std::mutex> lock(mutex);
+    next_pool_size = std::max<size_t>(first_pool_size, 1);
+    this->max_pool_size = std::max(next_pool_size, max_pool_size);
+    pool_growth_factor = std::max<size_t>(growth_factor, 1);
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::trim() {
+    ThreadCache* local = cache;
+    if (local != nullptr) {
+        if (local->spare_free != nullptr) {
+            release(local->spare_free);
+        }
+        if (local->next_free != nullptr) {
+            release(local->next_free);
+        }
+        local->next_free = local->spare_free = nullptr;
+        local->free_count = 0;
+        flush_outgoing(*local);
+        while (void* remote = take_remote(*local)) {
+            release(remote);
+        }
+    }
+    release_abandoned();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    release_empty_pools(0);
+}
+
+template<size_t chunkSize>
+AllocatorStats FixedAllocator<chunkSize>::stats() {
+    AllocatorStats result;
+    result.chunk_size = chunkSize;
+    std::lock_guard<std::mutex> lock(mutex);
+#ifdef FAST_ALLOCATOR_STATS
+    result.allocations = allocation_count.load(std::memory_order_relaxed);
+    result.frees = deallocation_count.load(std::memory_order_relaxed);
+    for (ThreadCache* local : caches) {
+        result.allocations += local->allocations.load(std::memory_order_relaxed);
+        result.frees += local->frees.load(std::memory_order_relaxed);
+    }
+    result.live_chunks = result.allocations - result.frees;
+#endif
+    result.pools = pools.size();
+    result.pool_bytes = pool_bytes;
+    result.peak_bytes = peak_pool_bytes;
+    return result;
+}
+
+template<size_t chunkSize>
+typename FixedAllocator<chunkSize>::ThreadCache* FixedAllocator<chunkSize>::get_cache() {
+    if (cache_destroyed) return nullptr;
+    static thread_local ThreadCache _cache;
+    cache = &_cache;
+    return cache;
+}
+
+template<size_t chunkSize>
+inline void FixedAllocator<chunkSize>::record(ThreadCache* local, size_t allocated, size_t freed) {
+#ifdef FAST_ALLOCATOR_STATS
+    if (local != nullptr) {
+        local->allocations.store(local->allocations.load(std::memory_order_relaxed) + allocated,
+                std::memory_order_relaxed);
+        local->frees.store(local->frees.load(std::memory_order_relaxed) + freed,
+                std::memory_order_relaxed);
+    } else {
+        allocation_count.fetch_add(allocated, std::memory_order_relaxed);
+        deallocation_count.fetch_add(freed, std::memory_order_relaxed);
+    }
+#else
+    static_cast<void>(local);
+    static_cast<void>(allocated);
+    static_cast<void>(freed);
+#endif
+}
+
+template<size_t chunkSize>
+void*& FixedAllocator<chunkSize>::next_chunk(void* chunk) {
+    return *reinterpret_cast<void**>(chunk);
+}
+
+template<size_t chunkSize>
+typename FixedAllocator<chunkSize>::SegmentHeader* FixedAllocator<chunkSize>::segment_of(void* chunk) {
+    return reinterpret_cast<SegmentHeader*>(reinterpret_cast<uintptr_t>(chunk) & ~(SEGMENT_SIZE - 1));
 }
 
 template<size_t chunkSize>
-void FixedAllocator<chunkSize>::add_pool() {
-    pools.push_back(::operator new(POOL_SIZE * chunkSize));
-    for (size_t i = 0; i < POOL_SIZE; ++i) {
-        next_free.push_back(reinterpret_cast<void*>(reinterpret_cast<char*>(pools.back())
-                + i * chunkSize * sizeof(char)));
+inline bool FixedAllocator<chunkSize>::is_remote(ThreadCache* local, void* chunk) {
+    RemoteList* owner = segment_of(chunk)->owner.load(std::memory_order_relaxed);
+    return owner != local->remote && owner != nullptr;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::push_remote(ThreadCache& local, void* chunk) {
+    RemoteList* owner = segment_of(chunk)->owner.load(std::memory_order_relaxed);
+    if (owner != local.outgoing_owner || local.outgoing_count == CACHE_BATCH_SIZE) {
+        flush_outgoing(local);
+        local.outgoing_owner = owner;
+        local.outgoing_last = chunk;
+    }
+    next_chunk(chunk) = local.outgoing;
+    local.outgoing = chunk;
+    ++local.outgoing_count;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::flush_outgoing(ThreadCache& local) {
+    if (local.outgoing == nullptr) return;
+    RemoteList* owner = local.outgoing_owner;
+    void* head = owner->head.load(std::memory_order_relaxed);
+    do {
+        next_chunk(local.outgoing_last) = head;
+    } while (!owner->head.compare_exchange_weak(head, local.outgoing, std::memory_order_release,
+            std::memory_order_relaxed));
+    local.outgoing = local.outgoing_last = nullptr;
+    local.outgoing_owner = nullptr;
+    local.outgoing_count = 0;
+}
+
+template<size_t chunkSize>
+void* FixedAllocator<chunkSize>::take_remote(ThreadCache& local) {
+    void* first = local.remote_pending;
+    local.remote_pending = nullptr;
+    if (first != nullptr || local.remote->head.load(std::memory_order_relaxed) == nullptr) {
+        return first;
+    }
+    return local.remote->head.exchange(nullptr, std::memory_order_acquire);
+}
+
+template<size_t chunkSize>
+size_t FixedAllocator<chunkSize>::add_pool() {
+    size_t pool_size = next_pool_size;
+    next_pool_size = std::min(max_pool_size, next_pool_size * pool_growth_factor);
+
+    size_t segments = (pool_size + CHUNKS_PER_SEGMENT - 1) / CHUNKS_PER_SEGMENT;
+    Pool pool;
+    pool.begin = reinterpret_cast<char*>(PoolMemory::allocate(segments * SEGMENT_SIZE, SEGMENT_SIZE));
+    pool.carve_begin = pool.begin + SEGMENT_HEADER_SIZE;
+    pool.end = pool.begin + segments * SEGMENT_SIZE;
+    pool.next_free = nullptr;
+    pool.used = 0;
+    for (char* segment = pool.begin; segment != pool.end; segment += SEGMENT_SIZE) {
+        new (segment) SegmentHeader{{nullptr}};
+    }
+    ++empty_pools;
+    pool_bytes += segments * SEGMENT_SIZE;
+    peak_pool_bytes = std::max(peak_pool_bytes, pool_bytes);
+
+    auto it = std::upper_bound(pools.begin(), pools.end(), pool.begin,
+            [](char* ptr, const Pool& another) { return ptr < another.begin; });
+    it = pools.insert(it, pool);
+    return it - pools.begin();
+}
+
+template<size_t chunkSize>
+size_t FixedAllocator<chunkSize>::find_pool(void* chunk) const {
+    auto it = std::upper_bound(pools.begin(), pools.end(), reinterpret_cast<char*>(chunk),
+            [](char* ptr, const Pool& pool) { return ptr < pool.begin; });
+    return it - pools.begin() - 1;
+}
+
+template<size_t chunkSize>
+size_t FixedAllocator<chunkSize>::choose_pool() const {
+    size_t best = pools.size();
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (pools[i].next_free == nullptr && pools[i].carve_begin == pools[i].end) continue;
+        if (best == pools.size() || pools[i].used > pools[best].used) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+template<size_t chunkSize>
+void* FixedAllocator<chunkSize>::take_chunks(size_t count, RemoteList* owner, bool contiguous) {
+    void* first = nullptr;
+    for (size_t i = 0; contiguous && count > 0 && i < pools.size(); ++i) {
+        while (count > 0 && pools[i].carve_begin != pools[i].end) {
+            if (pools[i].used == 0) {
+                --empty_pools;
+            }
+            size_t taken = carve_chunks(pools[i], count, owner, first);
+            pools[i].used += taken;
+            count -= taken;
+        }
+    }
+    while (count > 0) {
+        if (current_pool >= pools.size() || (pools[current_pool].next_free == nullptr &&
+                pools[current_pool].carve_begin == pools[current_pool].end)) {
+            current_pool = choose_pool();
+            if (current_pool == pools.size()) {
+                current_pool = add_pool();
+            }
+        }
+        Pool& pool = pools[current_pool];
+        if (pool.used == 0) {
+            --empty_pools;
+        }
+
+        size_t taken = 0;
+        if (pool.next_free != nullptr) {
+            void* last = pool.next_free;
+            for (taken = 1; taken < count && next_chunk(last) != nullptr; ++taken) {
+                last = next_chunk(last);
+            }
+            void* rest = next_chunk(last);
+            next_chunk(last) = first;
+            first = pool.next_free;
+            pool.next_free = rest;
+        } else {
+            taken = carve_chunks(pool, count, owner, first);
+        }
+        pool.used += taken;
+        count -= taken;
+    }
+    return first;
+}
+
+template<size_t chunkSize>
+size_t FixedAllocator<chunkSize>::carve_chunks(Pool& pool, size_t count, RemoteList* owner,
+        void*& first) {
+    char* segment = reinterpret_cast<char*>(segment_of(pool.carve_begin));
+    if (pool.carve_begin == segment + SEGMENT_HEADER_SIZE) {
+        segment_of(segment)->owner.store(owner, std::memory_order_relaxed);
+    }
+    size_t left = (segment + SEGMENT_HEADER_SIZE + CHUNKS_PER_SEGMENT * chunkSize
+            - pool.carve_begin) / chunkSize;
+    size_t taken = std::min(count, left);
+    for (size_t i = taken; i > 0; ) {
+        --i;
+        void* chunk = pool.carve_begin + i * chunkSize;
+        next_chunk(chunk) = first;
+        first = chunk;
+    }
+    pool.carve_begin += taken * chunkSize;
+    if (taken == left) {
+        pool.carve_begin = segment + SEGMENT_SIZE == pool.end ? pool.end
+                : segment + SEGMENT_SIZE + SEGMENT_HEADER_SIZE;
+    }
+    return taken;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::refill(ThreadCache& local) {
+    if (local.spare_free != nullptr) {
+        local.next_free = local.spare_free;
+        local.free_count = CACHE_BATCH_SIZE;
+        local.spare_free = nullptr;
+        return;
+    }
+
+    void* first = take_remote(local);
+    void* last = first;
+    size_t count = first != nullptr;
+    if (first != nullptr) {
+        while (count < CACHE_BATCH_SIZE && next_chunk(last) != nullptr) {
+            last = next_chunk(last);
+            ++count;
+        }
+        local.remote_pending = next_chunk(last);
+        next_chunk(last) = nullptr;
+    }
+
+    if (count < CACHE_BATCH_SIZE) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (local.remote_pending == nullptr) {
+            local.remote_pending = take_abandoned();
+        }
+        void* rest = take_chunks(CACHE_BATCH_SIZE - count, local.remote, false);
+        if (first != nullptr) {
+            next_chunk(last) = rest;
+        } else {
+            first = rest;
+        }
+        count = CACHE_BATCH_SIZE;
+    }
+    local.next_free = first;
+    local.free_count = count;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::flush(ThreadCache& local) {
+    if (local.spare_free != nullptr) {
+        release(local.spare_free);
+    }
+    local.spare_free = local.next_free;
+    local.next_free = nullptr;
+    local.free_count = 0;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::release(void* first) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t index = pools.size();
+    while (first != nullptr) {
+        if (index == pools.size() || first < pools[index].begin || first >= pools[index].end) {
+            index = find_pool(first);
+        }
+        Pool& pool = pools[index];
+
+        void* last = first;
+        size_t count = 1;
+        while (next_chunk(last) != nullptr && next_chunk(last) >= pool.begin &&
+                next_chunk(last) < pool.end) {
+            last = next_chunk(last);
+            ++count;
+        }
+        void* rest = next_chunk(last);
+        next_chunk(last) = pool.next_free;
+        pool.next_free = first;
+        first = rest;
+
+        pool.used -= count;
+        if (pool.used == 0) {
+            pool.next_free = nullptr;
+            pool.carve_begin = pool.begin + SEGMENT_HEADER_SIZE;
+            if (++empty_pools > Traits::MAX_EMPTY_POOLS) {
+                release_empty_pools(Traits::MAX_EMPTY_POOLS);
+                index = pools.size();
+            }
+        }
+    }
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::release_empty_pools(size_t keep) {
+    while (empty_pools > keep) {
+        size_t smallest = pools.size();
+        for (size_t i = 0; i < pools.size(); ++i) {
+            if (pools[i].used != 0) continue;
+            if (smallest == pools.size() ||
+                    pools[i].end - pools[i].begin < pools[smallest].end - pools[smallest].begin) {
+                smallest = i;
+            }
+        }
+        PoolMemory::deallocate(pools[smallest].begin, pools[smallest].end - pools[smallest].begin,
+                SEGMENT_SIZE);
+        pool_bytes -= pools[smallest].end - pools[smallest].begin;
+        pools.erase(pools.begin() + smallest);
+        --empty_pools;
+    }
+    current_pool = pools.size();
+}
+
+template<size_t chunkSize>
+void* FixedAllocator<chunkSize>::take_abandoned() {
+    for (RemoteList* list : abandoned_lists) {
+        if (list->head.load(std::memory_order_relaxed) != nullptr) {
+            return list->head.exchange(nullptr, std::memory_order_acquire);
+        }
+    }
+    return nullptr;
+}
+
+template<size_t chunkSize>
+void FixedAllocator<chunkSize>::release_abandoned() {
+    while (true) {
+        void* first;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            first = take_abandoned();
+        }
+        if (first == nullptr) return;
+        release(first);
     }
 }
 
+// *****
+// FixedAllocator::ThreadCache
+
+template<size_t chunkSize>
+FixedAllocator<chunkSize>::ThreadCache::ThreadCache() {
+    FixedAllocator<chunkSize>& central = get_instance();
+    std::lock_guard<std::mutex> lock(central.mutex);
+    if (!central.abandoned_lists.empty()) {
+        remote = central.abandoned_lists.back();
+        central.abandoned_lists.pop_back();
+    } else {
+        remote = new RemoteList();
+        central.remote_lists.push_back(remote);
+    }
+#ifdef FAST_ALLOCATOR_STATS
+    central.caches.push_back(this);
+#endif
+}
+
+template<size_t chunkSize>
+FixedAllocator<chunkSize>::ThreadCache::~ThreadCache() {
+    cache = nullptr;
+    cache_destroyed = true;
+    FixedAllocator<chunkSize>& central = get_instance();
+#ifdef FAST_ALLOCATOR_STATS
+    {
+        std::lock_guard<std::mutex> lock(central.mutex);
+        central.allocation_count += allocations.load(std::memory_order_relaxed);
+        central.deallocation_count += frees.load(std::memory_order_relaxed);
+        central.caches.erase(std::find(central.caches.begin(), central.caches.end(), this));
+    }
+#endif
+    flush_outgoing(*this);
+    if (next_free != nullptr) {
+        central.release(next_free);
+    }
+    if (spare_free != nullptr) {
+        central.release(spare_free);
+    }
+    while (void* pending = take_remote(*this)) {
+        central.release(pending);
+    }
+    std::lock_guard<std::mutex> lock(central.mutex);
+    central.abandoned_lists.push_back(remote);
+}
+
+// *****
+// SIZE CLASSES
+// *****
+
+template<size_t maxSize>
+constexpr size_t SizeClassTable<maxSize>::chunk_size(size_t index) {
+    if (index < QUANTUM_CLASS_LIMIT / QUANTUM) {
+        return (index + 1) * QUANTUM;
+    }
+    index -= QUANTUM_CLASS_LIMIT / QUANTUM;
+    size_t group_base = QUANTUM_CLASS_LIMIT << (index / CLASSES_PER_DOUBLING);
+    return group_base + (index % CLASSES_PER_DOUBLING + 1) * (group_base / CLASSES_PER_DOUBLING);
+}
+
+template<size_t maxSize>
+constexpr size_t SizeClassTable<maxSize>::count_classes() {
+    size_t count = 0;
+    while (chunk_size(count) < maxSize) {
+        ++count;
+    }
+    return count + 1;
+}
+
+template<size_t maxSize>
+constexpr std::array<unsigned char, maxSize / SizeClassTable<maxSize>::QUANTUM + 1>
+        SizeClassTable<maxSize>::make_lookup() {
+    std::array<unsigned char, maxSize / QUANTUM + 1> lookup{};
+    size_t index = 0;
+    for (size_t i = 0; i < lookup.size(); ++i) {
+        while (chunk_size(index) < i * QUANTUM) {
+            ++index;
+        }
+        lookup[i] = static_cast<unsigned char>(index);
+    }
+    return lookup;
+}
+
+template<size_t maxSize>
+const size_t SizeClassTable<maxSize>::COUNT = SizeClassTable<maxSize>::count_classes();
+
+template<size_t maxSize>
+const std::array<unsigned char, maxSize / SizeClassTable<maxSize>::QUANTUM + 1>
+        SizeClassTable<maxSize>::LOOKUP = SizeClassTable<maxSize>::make_lookup();
+
+template<size_t maxSize>
+constexpr size_t SizeClassTable<maxSize>::round_up(size_t bytes) {
+    size_t index = 0;
+    while (chunk_size(index) < bytes) {
+        ++index;
+    }
+    return chunk_size(index);
+}
+
+template<size_t maxSize>
+size_t SizeClassTable<maxSize>::index(size_t bytes) {
+    return LOOKUP[(bytes + QUANTUM - 1) / QUANTUM];
+}
+
+// *****
+
+template<size_t maxSize>
+template<size_t classIndex>
+void* SizeClassTable<maxSize>::allocate_chunk() {
+    return FixedAllocator<chunk_size(classIndex)>::get_instance().allocate();
+}
+
+template<size_t maxSize>
+template<size_t classIndex>
+void SizeClassTable<maxSize>::deallocate_chunk(void* ptr) {
+    FixedAllocator<chunk_size(classIndex)>::get_instance().deallocate(ptr);
+}
+
+template<size_t maxSize>
+template<size_t... indexes>
+constexpr std::array<void* (*)(), sizeof...(indexes)>
+        SizeClassTable<maxSize>::make_allocate_table(std::index_sequence<indexes...>) {
+    return {&allocate_chunk<indexes>...};
+}
+
+template<size_t maxSize>
+template<size_t... indexes>
+constexpr std::array<void (*)(void*), sizeof...(indexes)>
+        SizeClassTable<maxSize>::make_deallocate_table(std::index_sequence<indexes...>) {
+    return {&deallocate_chunk<indexes>...};
+}
+
+template<size_t maxSize>
+template<size_t... indexes>
+void SizeClassTable<maxSize>::trim_classes(std::index_sequence<indexes...>) {
+    (FixedAllocator<chunk_size(indexes)>::get_instance().trim(), ...);
+}
+
+template<size_t maxSize>
+void* SizeClassTable<maxSize>::allocate(size_t bytes) {
+    static constexpr auto table = make_allocate_table(std::make_index_sequence<count_classes()>());
+    return table[index(bytes)]();
+}
+
+template<size_t maxSize>
+void SizeClassTable<maxSize>::deallocate(void* ptr, size_t bytes) {
+    static constexpr auto table = make_deallocate_table(std::make_index_sequence<count_classes()>());
+    table[index(bytes)](ptr);
+}
+
+template<size_t maxSize>
+void SizeClassTable<maxSize>::trim() {
+    trim_classes(std::make_index_sequence<count_classes()>());
+}
+
+// *****
+
+template<size_t maxSize>
+template<size_t... indexes>
+std::vector<AllocatorStats> SizeClassTable<maxSize>::collect_stats(std::index_sequence<indexes...>) {
+    return {FixedAllocator<chunk_size(indexes)>::get_instance().stats()...};
+}
+
+template<size_t maxSize>
+std::vector<AllocatorStats> SizeClassTable<maxSize>::stats() {
+    std::vector<AllocatorStats> result = collect_stats(std::make_index_sequence<count_classes()>());
+    AllocatorStats fallback;
+#ifdef FAST_ALLOCATOR_STATS
+    fallback.allocations = fallback_counters().allocations.load(std::memory_order_relaxed);
+    fallback.frees = fallback_counters().frees.load(std::memory_order_relaxed);
+    fallback.live_chunks = fallback.allocations - fallback.frees;
+#endif
+    result.push_back(fallback);
+    return result;
+}
+
+template<size_t maxSize>
+void SizeClassTable<maxSize>::dump_stats(std::ostream& out) {
+    out << "chunk_size,allocations,frees,live_chunks,pools,pool_bytes,peak_bytes" << std::endl;
+    for (const AllocatorStats& row : stats()) {
+        if (row.chunk_size == 0) {
+            out << "operator_new";
+        } else {
+            out << row.chunk_size;
+        }
+        out << ',' << row.allocations << ',' << row.frees << ',' << row.live_chunks << ','
+                << row.pools << ',' << row.pool_bytes << ',' << row.peak_bytes << std::endl;
+    }
+}
+
+template<size_t maxSize>
+void SizeClassTable<maxSize>::record_fallback(size_t allocated, size_t freed) {
+#ifdef FAST_ALLOCATOR_STATS
+    fallback_counters().allocations.fetch_add(allocated, std::memory_order_relaxed);
+    fallback_counters().frees.fetch_add(freed, std::memory_order_relaxed);
+#else
+    static_cast<void>(allocated);
+    static_cast<void>(freed);
+#endif
+}
+
+template<size_t maxSize>
+typename SizeClassTable<maxSize>::FallbackCounters& SizeClassTable<maxSize>::fallback_counters() {
+    static FallbackCounters counters;
+    return counters;
+}
+
+template<size_t maxSize>
+SizeClassTable<maxSize>::FallbackCounters::~FallbackCounters() {
+    size_t live = allocations.load() - frees.load();
+    if (live != 0) {
+        std::cerr << "FastAllocator: " << live << " operator new allocations still live at exit"
+                << std::endl;
+    }
+}
+
+// *****
+// PRIVATE POOLS
+// *****
+
+inline ChunkPool::ChunkPool(size_t chunk_size): chunk_size(chunk_size), next_pool_size(FIRST_POOL_SIZE),
+        pools(std::vector<void*>(0)), next_free(nullptr), carve_begin(nullptr),
+        carve_end(nullptr) {}
+
+inline ChunkPool::ChunkPool(ChunkPool&& another): chunk_size(another.chunk_size),
+        next_pool_size(another.next_pool_size), pools(std::move(another.pools)),
+        next_free(another.next_free), carve_begin(another.carve_begin),
+        carve_end(another.carve_end) {
+    another.pools.clear();
+    another.next_free = nullptr;
+    another.carve_begin = another.carve_end = nullptr;
+}
+
+inline ChunkPool::~ChunkPool() {
+    for (size_t i = 0; i < pools.size(); ++i) {
+        ::operator delete(pools[i], std::align_val_t(POOL_ALIGNMENT));
+    }
+}
+
+inline void* ChunkPool::allocate() {
+    if (next_free != nullptr) {
+        void* ret = next_free;
+        next_free = *reinterpret_cast<void**>(ret);
+        return ret;
+    }
+    if (carve_begin == carve_end) {
+        add_pool();
+    }
+    void* ret = carve_begin;
+    carve_begin += chunk_size;
+    return ret;
+}
+
+inline void ChunkPool::deallocate(void* ptr) {
+    *reinterpret_cast<void**>(ptr) = next_free;
+    next_free = ptr;
+}
+
+inline void ChunkPool::add_pool() {
+    size_t pool_size = next_pool_size;
+    next_pool_size = std::max(next_pool_size, std::min(2 * next_pool_size, MAX_POOL_BYTES / chunk_size));
+
+    pools.push_back(::operator new(pool_size * chunk_size, std::align_val_t(POOL_ALIGNMENT)));
+    carve_begin = reinterpret_cast<char*>(pools.back());
+    carve_end = carve_begin + pool_size * chunk_size;
+}
+
+// *****
+
+inline PrivatePools::PrivatePools() {
+    classes.reserve(SizeClasses::COUNT);
+    for (size_t i = 0; i < SizeClasses::COUNT; ++i) {
+        classes.emplace_back(SizeClasses::chunk_size(i));
+    }
+}
+
+inline void* PrivatePools::allocate(size_t bytes) {
+    return classes[SizeClasses::index(bytes)].allocate();
+}
+
+inline void PrivatePools::deallocate(void* ptr, size_t bytes) {
+    classes[SizeClasses::index(bytes)].deallocate(ptr);
+}
+
 // *****
 // FAST ALLOC
 // *****
 
-template<typename T>
-FastAllocator<T>::FastAllocator():
-        fixed_alloc_1(FixedAllocator<FIXED_ALLOC_SIZE_1>::get_instance()),
-        fixed_alloc_2(FixedAllocator<FIXED_ALLOC_SIZE_2>::get_instance()),
-        fixed_alloc_3(FixedAllocator<FIXED_ALLOC_SIZE_3>::get_instance()) {}
+template<typename T, size_t minAlignment>
+FastAllocator<T, minAlignment>::FastAllocator(): fixed_alloc(NodeAllocator::get_instance()) {}
 
-template<typename T>
+template<typename T, size_t minAlignment>
+FastAllocator<T, minAlignment>::FastAllocator(const std::shared_ptr<PrivatePools>& own_pools):
+        fixed_alloc(NodeAllocator::get_instance()), own_pools(own_pools) {}
+
+template<typename T, size_t minAlignment>
 template<typename U>
-FastAllocator<T>::FastAllocator(const FastAllocator<U>&): FastAllocator<T>() {}
+FastAllocator<T, minAlignment>::FastAllocator(const FastAllocator<U, minAlignment>& another):
+        fixed_alloc(NodeAllocator::get_instance()), own_pools(another.own_pools) {}
 
-template<typename T>
-FastAllocator<T>& FastAllocator<T>::operator=(const FastAllocator<T>&) {
+template<typename T, size_t minAlignment>
+FastAllocator<T, minAlignment>& FastAllocator<T, minAlignment>::operator=(const FastAllocator<T, minAlignment>& another) {
+    own_pools = another.own_pools;
     return *this;
 }
 
 
+template<typename T, size_t minAlignment>
+FastAllocator<T, minAlignment>::~FastAllocator() = default;
+
+// *****
+
+template<typename T, size_t minAlignment>
+template<typename U>
+bool FastAllocator<T, minAlignment>::operator==(const FastAllocator<U, minAlignment>& another) {
+    return own_pools == another.own_pools;
+}
+
+template<typename T, size_t minAlignment>
+template<typename U>
+bool FastAllocator<T, minAlignment>::operator!=(const FastAllocator<U, minAlignment>& another) {
+    return !(*this == another);
+}
+
+template<typename T, size_t minAlignment>
+FastAllocator<T, minAlignment> FastAllocator<T, minAlignment>::select_on_container_copy_construction() const {
+    if (own_pools == nullptr) {
+        return *this;
+    }
+    return FastAllocator<T, minAlignment>(std::make_shared<PrivatePools>());
+}
+
+template<typename T, size_t minAlignment>
+void FastAllocator<T, minAlignment>::trim() {
+    SizeClasses::trim();
+}
+
+template<typename T, size_t minAlignment>
+std::vector<AllocatorStats> FastAllocator<T, minAlignment>::stats() {
+    return SizeClasses::stats();
+}
+
+template<typename T, size_t minAlignment>
+void FastAllocator<T, minAlignment>::dump_stats(std::ostream& out) {
+    SizeClasses::dump_stats(out);
+}
+
+template<typename T, size_t minAlignment>
+T* FastAllocator<T, minAlignment>::allocate(size_t n) {
+    size_t byte_count = aligned_bytes(n);
+    if constexpr (ALIGNMENT <= POOL_ALIGNMENT) {
+        if (own_pools != nullptr && byte_count <= MAX_SMALL_SIZE) {
+            return reinterpret_cast<T*>(own_pools->allocate(byte_count));
+        }
+        if constexpr (NODE_SIZE <= MAX_SMALL_SIZE) {
+            if (n == 1) {
+                return reinterpret_cast<T*>(fixed_alloc.allocate());
+            }
+        }
+        if (byte_count <= MAX_SMALL_SIZE) {
+            return reinterpret_cast<T*>(SizeClasses::allocate(byte_count));
+        }
+    }
+    SizeClasses::record_fallback(1, 0);
+    if constexpr (ALIGNMENT > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        return reinterpret_cast<T*>(::operator new(byte_count, std::align_val_t(ALIGNMENT)));
+    }
+    return reinterpret_cast<T*>(::operator new(byte_count));
+}
+
+template<typename T, size_t minAlignment>
+void FastAllocator<T, minAlignment>::deallocate(T* ptr, size_t n) {
+    size_t byte_count = aligned_bytes(n);
+    if constexpr (ALIGNMENT <= POOL_ALIGNMENT) {
+        if (own_pools != nullptr && byte_count <= MAX_SMALL_SIZE) {
+            own_pools->deallocate(reinterpret_cast<void*>(ptr), byte_count);
+            return;
+        }
+        if constexpr (NODE_SIZE <= MAX_SMALL_SIZE) {
+            if (n == 1) {
+                fixed_alloc.deallocate(reinterpret_cast<void*>(ptr));
+                return;
+            }
+        }
+        if (byte_count <= MAX_SMALL_SIZE) {
+            SizeClasses::deallocate(reinterpret_cast<void*>(ptr), byte_count);
+            return;
+        }
+    }
+    SizeClasses::record_fallback(0, 1);
+    if constexpr (ALIGNMENT > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+        ::operator delete(ptr, std::align_val_t(ALIGNMENT));
+    } else {
+        ::operator delete(ptr);
+    }
+}
+
+template<typename T, size_t minAlignment>
+void FastAllocator<T, minAlignment>::allocate_bulk(size_t count, T** out, bool contiguous) {
+    if constexpr (ALIGNMENT <= POOL_ALIGNMENT && NODE_SIZE <= MAX_SMALL_SIZE) {
+        if (own_pools == nullptr) {
+            fixed_alloc.allocate_bulk(count, reinterpret_cast<void**>(out), contiguous);
+            return;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = allocate(1);
+    }
+}
+
+template<typename T, size_t minAlignment>
+void FastAllocator<T, minAlignment>::deallocate_bulk(T** ptrs, size_t count) {
+    if constexpr (ALIGNMENT <= POOL_ALIGNMENT && NODE_SIZE <= MAX_SMALL_SIZE) {
+        if (own_pools == nullptr) {
+            fixed_alloc.deallocate_bulk(reinterpret_cast<void**>(ptrs), count);
+            return;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        deallocate(ptrs[i], 1);
+    }
+}
+
+template<typename T, size_t minAlignment>
+size_t FastAllocator<T, minAlignment>::aligned_bytes(size_t n) {
+    if (n == 1) {
+        return NODE_SIZE;
+    }
+    return (n * sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+// *****
+// FAST MEMORY RESOURCE
+// *****
+
+inline FastMemoryResource::FastMemoryResource(): upstream(std::pmr::get_default_resource()) {}
+
+inline FastMemoryResource::FastMemoryResource(const std::shared_ptr<PrivatePools>& own_pools,
+        std::pmr::memory_resource* upstream): own_pools(own_pools), upstream(upstream) {}
+
+inline std::pmr::memory_resource* FastMemoryResource::upstream_resource() const {
+    return upstream;
+}
+
+// *****
+
+inline size_t FastMemoryResource::pooled_size(size_t bytes, size_t alignment) {
+    if (alignment > POOL_ALIGNMENT) return 0;
+    size_t size = (std::max<size_t>(bytes, 1) + alignment - 1) / alignment * alignment;
+    return size <= MAX_SMALL_SIZE ? size : 0;
+}
+
+inline void* FastMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    size_t size = pooled_size(bytes, alignment);
+    if (size == 0) {
+        return upstream->allocate(bytes, alignment);
+    }
+    if (own_pools != nullptr) {
+        return own_pools->allocate(size);
+    }
+    return SizeClasses::allocate(size);
+}
+
+inline void FastMemoryResource::do_deallocate(void* ptr, size_t bytes, size_t alignment) {
+    size_t size = pooled_size(bytes, alignment);
+    if (size == 0) {
+        upstream->deallocate(ptr, bytes, alignment);
+    } else if (own_pools != nullptr) {
+        own_pools->deallocate(ptr, size);
+    } else {
+        SizeClasses::deallocate(ptr, size);
+    }
+}
+
+inline bool FastMemoryResource::do_is_equal(const std::pmr::memory_resource& another) const noexcept {
+    if (this == &another) return true;
+    const FastMemoryResource* other = dynamic_cast<const FastMemoryResource*>(&another);
+    return other != nullptr && own_pools == other->own_pools && *upstream == *other->upstream;
+}
+
+// *****
+// ARENA
+// *****
+
+inline Arena::Arena(size_t first_block_size): blocks(nullptr), current(nullptr), end(nullptr),
+        first_block_size(std::max(first_block_size, sizeof(Block))),
+        next_block_size(this->first_block_size), reserved(0) {}
+
+inline Arena::~Arena() {
+    reset();
+}
+
+// *****
+
+inline void* Arena::allocate(size_t bytes, size_t alignment) {
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+    if (current == nullptr || static_cast<size_t>(end - current) < bytes + padding) {
+        add_block(bytes + alignment);
+        padding = (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+    }
+    void* ret = current + padding;
+    current += padding + bytes;
+    return ret;
+}
+
+inline void Arena::reset() {
+    while (blocks != nullptr) {
+        Block* prev = blocks->prev;
+        ::operator delete(blocks);
+        blocks = prev;
+    }
+    current = end = nullptr;
+    next_block_size = first_block_size;
+    reserved = 0;
+}
+
+inline size_t Arena::bytes_reserved() const {
+    return reserved;
+}
+
+inline void Arena::add_block(size_t min_size) {
+    size_t size = std::max(next_block_size, min_size + sizeof(Block));
+    next_block_size = std::min(MAX_BLOCK_SIZE, next_block_size * 2);
+
+    Block* block = reinterpret_cast<Block*>(::operator new(size));
+    block->prev = blocks;
+    block->size = size;
+    blocks = block;
+    current = reinterpret_cast<char*>(block) + sizeof(Block);
+    end = reinterpret_cast<char*>(block) + size;
+    reserved += size;
+}
+
+// *****
+// ARENA ALLOC
+// *****
+
 template<typename T>
-FastAllocator<T>::~FastAllocator() = default;
+ArenaAllocator<T>::ArenaAllocator(): arena(std::make_shared<Arena>()) {}
+
+template<typename T>
+ArenaAllocator<T>::ArenaAllocator(const std::shared_ptr<Arena>& arena): arena(arena) {}
+
+template<typename T>
+template<typename U>
+ArenaAllocator<T>::ArenaAllocator(const ArenaAllocator<U>& another): arena(another.arena) {}
 
 // *****
 
 template<typename T>
 template<typename U>
-bool FastAllocator<T>::operator==(const FastAllocator<U>& another) {
-    return true;
+bool ArenaAllocator<T>::operator==(const ArenaAllocator<U>& another) const {
+    return arena == another.arena;
 }
 
 template<typename T>
 template<typename U>
-bool FastAllocator<T>::operator!=(const FastAllocator<U>& another) {
+bool ArenaAllocator<T>::operator!=(const ArenaAllocator<U>& another) const {
     return !(*this == another);
 }
 
 template<typename T>
-T* FastAllocator<T>::allocate(size_t n) {
-    size_t byte_count = n * sizeof(T);
-    if (byte_count <= FIXED_ALLOC_SIZE_1) {
-        return reinterpret_cast<T*>(fixed_alloc_1.allocate());
-    } else if (byte_count <= FIXED_ALLOC_SIZE_2) {
-        return reinterpret_cast<T*>(fixed_alloc_2.allocate());
-    } else if (byte_count <= FIXED_ALLOC_SIZE_3) {
-        return reinterpret_cast<T*>(fixed_alloc_3.allocate());
-    } else {
-        return reinterpret_cast<T*>(::operator new(byte_count));
-    }
+T* ArenaAllocator<T>::allocate(size_t n) {
+    return reinterpret_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
 }
 
 template<typename T>
-void FastAllocator<T>::deallocate(T* ptr, size_t n) {
-    size_t byte_count = n * sizeof(T);
-    if (byte_count <= FIXED_ALLOC_SIZE_1) {
-        fixed_alloc_1.deallocate(reinterpret_cast<void*>(ptr));
-    } else if (byte_count <= FIXED_ALLOC_SIZE_2) {
-        fixed_alloc_2.deallocate(reinterpret_cast<void*>(ptr));
-    } else if (byte_count <= FIXED_ALLOC_SIZE_3) {
-        fixed_alloc_3.deallocate(reinterpret_cast<void*>(ptr));
-    } else {
-        ::operator delete(ptr);
-    }
+void ArenaAllocator<T>::deallocate(T*, size_t) {}
+
+template<typename T>
+void ArenaAllocator<T>::reset() {
+    arena->reset();
+}
+
+template<typename T>
+std::shared_ptr<Arena> ArenaAllocator<T>::get_arena() const {
+    return arena;
 }
@@ -1,5 +1,65 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
+#include <mutex>
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <cstdint>
+#include <atomic>
+#include <new>
+
+#if defined(FAST_ALLOCATOR_MMAP_POOLS) && defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifndef FAST_ALLOCATOR_MAX_SMALL_SIZE
+#define FAST_ALLOCATOR_MAX_SMALL_SIZE 1024
+#endif
+
+#ifndef FAST_ALLOCATOR_CACHE_LINE_SIZE
+#define FAST_ALLOCATOR_CACHE_LINE_SIZE 64
+#endif
+
+template<size_t chunkSize>
+struct FixedAllocatorTraits {
+    inline static const size_t FIRST_POOL_SIZE = 1000;
+    inline static const size_t POOL_GROWTH_FACTOR = 2;
+    inline static const size_t MAX_POOL_BYTES = 1 << 24;
+    inline static const size_t MAX_EMPTY_POOLS = 1;
+};
+
+class PoolMemory {
+  public:
+    static void* allocate(size_t bytes, size_t alignment);
+    static void deallocate(void* ptr, size_t bytes, size_t alignment);
+
+    static void set_huge_pages(bool enabled);
+    static void set_prefault(bool enabled);
+  private:
+    inline static const size_t ALIGNMENT = FAST_ALLOCATOR_CACHE_LINE_SIZE;
+    inline static const size_t HUGE_PAGE_SIZE = 1 << 21;
+
+    static size_t mapped_size(size_t bytes);
+
+    inline static std::atomic<bool> huge_pages{true};
+    inline static std::atomic<bool> prefault{false};
+};
+
+struct AllocatorStats {
+    size_t chunk_size = 0;
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t live_chunks = 0;
+    size_t pools = 0;
+    size_t pool_bytes = 0;
+    size_t peak_bytes = 0;
+};
 
 template<size_t chunkSize>
 class FixedAllocator {
@@ -12,43 +72,338 @@ class FixedAllocator {
 
     void* allocate();
     void deallocate(void* ptr);
+    void allocate_bulk(size_t count, void** out, bool contiguous = false);
+    void deallocate_bulk(void** ptrs, size_t count);
+
+    void set_pool_sizes(size_t first_pool_size, size_t max_pool_size,
+            size_t growth_factor = Traits::POOL_GROWTH_FACTOR);
+    void trim();
+
+    AllocatorStats stats();
   private:
+    using Traits = FixedAllocatorTraits<chunkSize>;
+
+    struct alignas(FAST_ALLOCATOR_CACHE_LINE_SIZE) RemoteList {
+        std::atomic<void*> head{nullptr};
+    };
+
+    struct SegmentHeader {
+        std::atomic<RemoteList*> owner;
+    };
+
+    struct ThreadCache {
+        void* next_free = nullptr;
+        size_t free_count = 0;
+        void* spare_free = nullptr;
+        RemoteList* remote = nullptr;
+        void* remote_pending = nullptr;
+        RemoteList* outgoing_owner = nullptr;
+        void* outgoing = nullptr;
+        void* outgoing_last = nullptr;
+        size_t outgoing_count = 0;
+
+#ifdef FAST_ALLOCATOR_STATS
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> frees{0};
+#endif
+
+        ThreadCache();
+        ~ThreadCache();
+    };
+
+    struct Pool {
+        char* begin;
+        char* carve_begin;
+        char* end;
+        void* next_free;
+        size_t used;
+    };
+
     FixedAllocator();
 
+    static ThreadCache* get_cache();
+    static void*& next_chunk(void* chunk);
+    static SegmentHeader* segment_of(void* chunk);
+    static bool is_remote(ThreadCache* local, void* chunk);
+    static void push_remote(ThreadCache& local, void* chunk);
+    static void flush_outgoing(ThreadCache& local);
+    static void* take_remote(ThreadCache& local);
+
+    void* allocate_slow();
+    void deallocate_slow(void* ptr);
+
+    size_t add_pool();
+    size_t find_pool(void* chunk) const;
+    size_t choose_pool() const;
+    void* take_chunks(size_t count, RemoteList* owner, bool contiguous);
+    size_t carve_chunks(Pool& pool, size_t count, RemoteList* owner, void*& first);
+    void refill(ThreadCache& local);
+    void flush(ThreadCache& local);
+    void release(void* first);
+    void release_empty_pools(size_t keep);
+    void* take_abandoned();
+    void release_abandoned();
+    void record(ThreadCache* local, size_t allocated, size_t freed);
+
+    inline static const size_t CACHE_BATCH_SIZE = 64;
+    inline static const size_t SEGMENT_HEADER_SIZE = FAST_ALLOCATOR_CACHE_LINE_SIZE;
+    static constexpr size_t SEGMENT_SIZE = []() {
+        size_t size = 1 << 16;
+        while (size < 16 * chunkSize) {
+            size *= 2;
+        }
+        return size;
+    }();
+    static constexpr size_t CHUNKS_PER_SEGMENT = (SEGMENT_SIZE - SEGMENT_HEADER_SIZE) / chunkSize;
+
+    static_assert(chunkSize >= sizeof(void*), "chunk must fit a free list link");
+
+    inline static thread_local ThreadCache* cache = nullptr;
+    inline static thread_local bool cache_destroyed = false;
+
+    std::mutex mutex;
+    std::vector<Pool> pools;
+    size_t current_pool;
+    size_t empty_pools;
+    size_t next_pool_size;
+    size_t max_pool_size;
+    size_t pool_growth_factor;
+    size_t pool_bytes;
+    size_t peak_pool_bytes;
+    std::vector<RemoteList*> remote_lists;
+    std::vector<RemoteList*> abandoned_lists;
+
+#ifdef FAST_ALLOCATOR_STATS
+    std::atomic<size_t> allocation_count{0};
+    std::atomic<size_t> deallocation_count{0};
+    std::vector<ThreadCache*> caches;
+#endif
+};
+
+template<size_t maxSize>
+class SizeClassTable {
+  public:
+    static constexpr size_t chunk_size(size_t index);
+    static constexpr size_t round_up(size_t bytes);
+    static size_t index(size_t bytes);
+
+    static void* allocate(size_t bytes);
+    static void deallocate(void* ptr, size_t bytes);
+    static void trim();
+
+    static std::vector<AllocatorStats> stats();
+    static void dump_stats(std::ostream& out);
+    static void record_fallback(size_t allocated, size_t freed);
+
+    static const size_t COUNT;
+  private:
+    struct FallbackCounters {
+        std::atomic<size_t> allocations{0};
+        std::atomic<size_t> frees{0};
+
+        ~FallbackCounters();
+    };
+
+    static FallbackCounters& fallback_counters();
+    static constexpr size_t QUANTUM = 8;
+    static constexpr size_t QUANTUM_CLASS_LIMIT = 64;
+    static constexpr size_t CLASSES_PER_DOUBLING = 4;
+
+    static constexpr size_t count_classes();
+    static constexpr std::array<unsigned char, maxSize / QUANTUM + 1> make_lookup();
+
+    template<size_t classIndex>
+    static void* allocate_chunk();
+    template<size_t classIndex>
+    static void deallocate_chunk(void* ptr);
+    template<size_t... indexes>
+    static constexpr std::array<void* (*)(), sizeof...(indexes)>
+            make_allocate_table(std::index_sequence<indexes...>);
+    template<size_t... indexes>
+    static constexpr std::array<void (*)(void*), sizeof...(indexes)>
+            make_deallocate_table(std::index_sequence<indexes...>);
+    template<size_t... indexes>
+    static void trim_classes(std::index_sequence<indexes...>);
+    template<size_t... indexes>
+    static std::vector<AllocatorStats> collect_stats(std::index_sequence<indexes...>);
+
+    static const std::array<unsigned char, maxSize / QUANTUM + 1> LOOKUP;
+};
+
+class ChunkPool {
+  public:
+    explicit ChunkPool(size_t chunk_size);
+    ChunkPool(ChunkPool&& another);
+    ChunkPool(const ChunkPool&) = delete;
+    ChunkPool& operator=(const ChunkPool&) = delete;
+    ~ChunkPool();
+
+    void* allocate();
+    void deallocate(void* ptr);
+  private:
     void add_pool();
 
-    static const size_t POOL_SIZE = 1000;
+    inline static const size_t FIRST_POOL_SIZE = 64;
+    inline static const size_t MAX_POOL_BYTES = 1 << 20;
+    inline static const size_t POOL_ALIGNMENT = FAST_ALLOCATOR_CACHE_LINE_SIZE;
+
+    size_t chunk_size;
+    size_t next_pool_size;
     std::vector<void*> pools;
-    std::vector<void*> next_free;
+    void* next_free;
+    char* carve_begin;
+    char* carve_end;
 };
 
-template<typename T>
+class PrivatePools {
+  public:
+    PrivatePools();
+    PrivatePools(const PrivatePools&) = delete;
+    PrivatePools& operator=(const PrivatePools&) = delete;
+
+    void* allocate(size_t bytes);
+    void deallocate(void* ptr, size_t bytes);
+  private:
+    using SizeClasses = SizeClassTable<FAST_ALLOCATOR_MAX_SMALL_SIZE>;
+
+    std::vector<ChunkPool> classes;
+};
+
+template<typename T, size_t minAlignment = 1>
 class FastAllocator {
   public:
     FastAllocator();
+    explicit FastAllocator(const std::shared_ptr<PrivatePools>& own_pools);
     template<typename U>
-    FastAllocator(const FastAllocator<U>&);
-    FastAllocator<T>& operator=(const FastAllocator<T>&);
+    FastAllocator(const FastAllocator<U, minAlignment>& another);
+    FastAllocator<T, minAlignment>& operator=(const FastAllocator<T, minAlignment>& another);
 
     ~FastAllocator();
 
     template<typename U>
-    bool operator==(const FastAllocator<U>& another);
+    bool operator==(const FastAllocator<U, minAlignment>& another);
     template<typename U>
-    bool operator!=(const FastAllocator<U>& another);
+    bool operator!=(const FastAllocator<U, minAlignment>& another);
 
     T* allocate(size_t n);
     void deallocate(T* ptr, size_t n);
+    void allocate_bulk(size_t count, T** out, bool contiguous = false);
+    void deallocate_bulk(T** ptrs, size_t count);
+
+    static void trim();
+    static std::vector<AllocatorStats> stats();
+    static void dump_stats(std::ostream& out);
+
+    FastAllocator<T, minAlignment> select_on_container_copy_construction() const;
 
     using value_type = T;
-  private:
-    inline static const size_t FIXED_ALLOC_SIZE_1 = 8;
-    inline static const size_t FIXED_ALLOC_SIZE_2 = 24;
-    inline static const size_t FIXED_ALLOC_SIZE_3 = 48;
-    FixedAllocator<FIXED_ALLOC_SIZE_1>& fixed_alloc_1;
-    FixedAllocator<FIXED_ALLOC_SIZE_2>& fixed_alloc_2;
-    FixedAllocator<FIXED_ALLOC_SIZE_3>& fixed_alloc_3;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
 
     template<typename U>
+    struct rebind {
+        using other = FastAllocator<U, minAlignment>;
+    };
+  private:
+    inline static const size_t MAX_SMALL_SIZE = FAST_ALLOCATOR_MAX_SMALL_SIZE;
+    inline static const size_t POOL_ALIGNMENT = FAST_ALLOCATOR_CACHE_LINE_SIZE;
+    static constexpr size_t ALIGNMENT = std::max(alignof(T), minAlignment);
+    static constexpr size_t NODE_SIZE = (sizeof(T) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    using SizeClasses = SizeClassTable<MAX_SMALL_SIZE>;
+    using NodeAllocator = FixedAllocator<SizeClasses::round_up(std::min(NODE_SIZE, MAX_SMALL_SIZE))>;
+
+    static size_t aligned_bytes(size_t n);
+
+    NodeAllocator& fixed_alloc;
+    std::shared_ptr<PrivatePools> own_pools;
+
+    template<typename U, size_t>
     friend class FastAllocator;
 };
+
+template<typename T>
+using CacheLineAllocator = FastAllocator<T, FAST_ALLOCATOR_CACHE_LINE_SIZE>;
+
+class FastMemoryResource : public std::pmr::memory_resource {
+  public:
+    FastMemoryResource();
+    explicit FastMemoryResource(const std::shared_ptr<PrivatePools>& own_pools,
+            std::pmr::memory_resource* upstream = std::pmr::get_default_resource());
+
+    std::pmr::memory_resource* upstream_resource() const;
+  private:
+    inline static const size_t MAX_SMALL_SIZE = FAST_ALLOCATOR_MAX_SMALL_SIZE;
+    inline static const size_t POOL_ALIGNMENT = FAST_ALLOCATOR_CACHE_LINE_SIZE;
+    using SizeClasses = SizeClassTable<MAX_SMALL_SIZE>;
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& another) const noexcept override;
+
+    static size_t pooled_size(size_t bytes, size_t alignment);
+
+    std::shared_ptr<PrivatePools> own_pools;
+    std::pmr::memory_resource* upstream;
+};
+
+class Arena {
+  public:
+    explicit Arena(size_t first_block_size = FIRST_BLOCK_SIZE);
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena();
+
+    void* allocate(size_t bytes, size_t alignment);
+    void reset();
+
+    size_t bytes_reserved() const;
+  private:
+    struct Block {
+        Block* prev;
+        size_t size;
+    };
+
+    void add_block(size_t min_size);
+
+    inline static const size_t FIRST_BLOCK_SIZE = 4096;
+    inline static const size_t MAX_BLOCK_SIZE = 1 << 24;
+
+    Block* blocks;
+    char* current;
+    char* end;
+    size_t first_block_size;
+    size_t next_block_size;
+    size_t reserved;
+};
+
+template<typename T>
+class ArenaAllocator {
+  public:
+    ArenaAllocator();
+    explicit ArenaAllocator(const std::shared_ptr<Arena>& arena);
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& another);
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& another) const;
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& another) const;
+
+    T* allocate(size_t n);
+    void deallocate(T* ptr, size_t n);
+
+    void reset();
+    std::shared_ptr<Arena> get_arena() const;
+
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+  private:
+    std::shared_ptr<Arena> arena;
+
+    template<typename U>
+    friend class ArenaAllocator;
+};
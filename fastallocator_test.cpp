@@ -0,0 +1,502 @@
+#define FAST_ALLOCATOR_STATS
+
+#include "fastallocator.cpp"
+#include "list.cpp"
+
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <random>
+#include <thread>
+#include <future>
+#include <condition_variable>
+#include <deque>
+#include <set>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "fastallocator_test: " << what << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+void test_arena() {
+    Arena arena(256);
+    std::mt19937 random(32);
+    std::vector<std::pair<unsigned char*, size_t>> blocks;
+    for (int i = 0; i < 2000; ++i) {
+        size_t bytes = 1 + random() % (i % 100 == 0 ? 10000 : 64);
+        size_t alignment = size_t(1) << (random() % 7);
+        unsigned char* ptr = static_cast<unsigned char*>(arena.allocate(bytes, alignment));
+        check(reinterpret_cast<uintptr_t>(ptr) % alignment == 0, "arena alignment");
+        std::memset(ptr, i & 0xff, bytes);
+        blocks.emplace_back(ptr, bytes);
+    }
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        for (size_t j = 0; j < blocks[i].second; ++j) {
+            check(blocks[i].first[j] == (i & 0xff), "arena allocations do not overlap");
+        }
+    }
+    check(arena.bytes_reserved() > 0, "arena reserves blocks");
+    arena.reset();
+    check(arena.bytes_reserved() == 0, "reset releases every block");
+    check(arena.allocate(16, 16) != nullptr, "arena is reusable after reset");
+}
+
+void test_arena_allocator() {
+    std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+    ArenaAllocator<int> alloc(arena);
+    check(alloc == ArenaAllocator<long>(arena), "allocators on one arena are equal");
+    check(alloc != ArenaAllocator<int>(), "allocators on different arenas differ");
+
+    std::vector<int, ArenaAllocator<int>> vector(alloc);
+    List<int, ArenaAllocator<int>> list(alloc);
+    std::list<int> expected;
+    for (int i = 0; i < 1000; ++i) {
+        vector.push_back(i);
+        list.push_back(i);
+        expected.push_back(i);
+    }
+    check(std::equal(list.begin(), list.end(), expected.begin(), expected.end()),
+            "List on an arena");
+    check(std::equal(vector.begin(), vector.end(), expected.begin(), expected.end()),
+            "vector on an arena");
+
+    using Map = std::map<int, int, std::less<int>, ArenaAllocator<std::pair<const int, int>>>;
+    Map map{ArenaAllocator<std::pair<const int, int>>(arena)};
+    for (int i = 0; i < 1000; ++i) {
+        map[i % 97] += i;
+    }
+    Map copy = map;
+    check(copy == map && copy.get_allocator() == map.get_allocator(), "copies share the arena");
+}
+
+class CountingResource : public std::pmr::memory_resource {
+  public:
+    size_t allocations = 0;
+    size_t live = 0;
+
+  private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        ++live;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override {
+        --live;
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& another) const noexcept override {
+        return this == &another;
+    }
+};
+
+void test_fast_memory_resource() {
+    CountingResource upstream;
+    {
+        FastMemoryResource resource(nullptr, &upstream);
+        std::pmr::list<int> list(&resource);
+        std::pmr::unordered_map<int, int> map(&resource);
+        std::list<int> expected;
+        std::mt19937 random(34);
+        for (int i = 0; i < 5000; ++i) {
+            int value = random() % 1000;
+            list.push_back(value);
+            map[value] += 1;
+            expected.push_back(value);
+            if (random() % 3 == 0) {
+                map.erase(list.front());
+                list.pop_front();
+                expected.pop_front();
+            }
+        }
+        check(std::equal(list.begin(), list.end(), expected.begin(), expected.end()),
+                "pmr list on FastMemoryResource");
+        size_t small_requests = upstream.allocations;
+
+        void* large = resource.allocate(FAST_ALLOCATOR_MAX_SMALL_SIZE + 1);
+        void* aligned = resource.allocate(8, 2 * FAST_ALLOCATOR_CACHE_LINE_SIZE);
+        check(upstream.allocations == small_requests + 2, "large and over-aligned go upstream");
+        check(reinterpret_cast<uintptr_t>(aligned) % (2 * FAST_ALLOCATOR_CACHE_LINE_SIZE) == 0,
+                "over-aligned request is honoured");
+        void* pooled = resource.allocate(24, 8);
+        check(upstream.allocations == small_requests + 2, "small requests use the pools");
+        resource.deallocate(pooled, 24, 8);
+        resource.deallocate(aligned, 8, 2 * FAST_ALLOCATOR_CACHE_LINE_SIZE);
+        resource.deallocate(large, FAST_ALLOCATOR_MAX_SMALL_SIZE + 1);
+    }
+    check(upstream.live == 0, "upstream allocations are returned");
+
+    FastMemoryResource shared;
+    FastMemoryResource other_shared;
+    std::shared_ptr<PrivatePools> pools = std::make_shared<PrivatePools>();
+    FastMemoryResource own(pools);
+    FastMemoryResource same_pools(pools);
+    check(shared == other_shared, "resources on the shared pools are equal");
+    check(own == same_pools && !(own == shared), "resources compare by their pools");
+
+    std::pmr::vector<std::pmr::string> strings(&own);
+    for (int i = 0; i < 100; ++i) {
+        strings.emplace_back(std::to_string(i) + " a string long enough to allocate");
+    }
+    check(strings[42].substr(0, 3) == "42 " && strings[42].get_allocator() == &own,
+            "allocator propagates to nested pmr containers");
+}
+
+void test_trim_between_remote_frees() {
+    FixedAllocator<32>& fixed = FixedAllocator<32>::get_instance();
+    std::vector<void*> chunks;
+    std::promise<void> allocated;
+    std::promise<void> freed;
+    std::thread owner([&] {
+        for (int i = 0; i < 200; ++i) {
+            chunks.push_back(fixed.allocate());
+        }
+        allocated.set_value();
+        freed.get_future().wait();
+        // the remote frees come back to the owner through its remote list
+        std::vector<void*> again;
+        for (int i = 0; i < 200; ++i) {
+            again.push_back(fixed.allocate());
+        }
+        for (void* chunk : again) {
+            fixed.deallocate(chunk);
+        }
+    });
+    allocated.get_future().wait();
+    std::thread([&] {
+        for (int i = 0; i < 10; ++i) {
+            fixed.deallocate(chunks[i]);
+        }
+        fixed.trim();
+        for (int i = 10; i < 200; ++i) {
+            fixed.deallocate(chunks[i]);
+        }
+    }).join();
+    freed.set_value();
+    owner.join();
+}
+
+void test_thread_caches() {
+    FixedAllocator<72>& fixed = FixedAllocator<72>::get_instance();
+    std::vector<std::thread> threads;
+    for (size_t id = 0; id < 4; ++id) {
+        threads.emplace_back([&fixed, id] {
+            std::vector<size_t*> chunks;
+            for (size_t i = 0; i < 1000; ++i) {
+                size_t* chunk = static_cast<size_t*>(fixed.allocate());
+                std::fill(chunk, chunk + 9, id);
+                chunks.push_back(chunk);
+            }
+            for (size_t* chunk : chunks) {
+                check(std::count(chunk, chunk + 9, id) == 9, "threads get disjoint chunks");
+            }
+            for (size_t* chunk : chunks) {
+                fixed.deallocate(chunk);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    AllocatorStats stats = fixed.stats();
+    check(stats.allocations == 4 * 1000 && stats.frees == 4 * 1000 && stats.live_chunks == 0,
+            "counters of exited thread caches");
+}
+
+void test_remote_frees() {
+    FixedAllocator<88>& fixed = FixedAllocator<88>::get_instance();
+    const size_t PRODUCERS = 2;
+    const size_t CONSUMERS = 2;
+    const size_t ITEMS = 20000;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<size_t*> queue;
+    size_t producers_left = PRODUCERS;
+
+    std::vector<std::thread> threads;
+    for (size_t id = 0; id < PRODUCERS; ++id) {
+        threads.emplace_back([&, id] {
+            for (size_t i = 0; i < ITEMS; ++i) {
+                size_t* chunk = static_cast<size_t*>(fixed.allocate());
+                std::fill(chunk, chunk + 11, id * ITEMS + i);
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.push_back(chunk);
+                ready.notify_one();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            --producers_left;
+            ready.notify_all();
+        });
+    }
+    for (size_t id = 0; id < CONSUMERS; ++id) {
+        threads.emplace_back([&] {
+            while (true) {
+                size_t* chunk;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [&] { return !queue.empty() || producers_left == 0; });
+                    if (queue.empty()) return;
+                    chunk = queue.front();
+                    queue.pop_front();
+                }
+                check(std::count(chunk, chunk + 11, chunk[0]) == 11, "chunk is intact when freed");
+                fixed.deallocate(chunk);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    AllocatorStats stats = fixed.stats();
+    check(stats.allocations == PRODUCERS * ITEMS && stats.live_chunks == 0,
+            "remote frees are counted");
+    check(stats.pools > 0, "pools are kept until trim");
+    fixed.trim();
+    check(fixed.stats().pools == 0, "trim releases the abandoned remote lists");
+}
+
+void test_abandoned_lists() {
+    FixedAllocator<104>& fixed = FixedAllocator<104>::get_instance();
+    std::vector<void*> chunks;
+    std::promise<void> allocated;
+    std::promise<void> freer_ready;
+    std::promise<void> owner_exited;
+    std::thread owner([&] {
+        for (int i = 0; i < 500; ++i) {
+            chunks.push_back(fixed.allocate());
+        }
+        allocated.set_value();
+        freer_ready.get_future().wait();
+    });
+    // the freer sets up its cache while the owner is alive, so it cannot adopt the owner's list
+    std::thread freer([&] {
+        allocated.get_future().wait();
+        fixed.deallocate(fixed.allocate());
+        freer_ready.set_value();
+        owner_exited.get_future().wait();
+        for (void* chunk : chunks) {
+            fixed.deallocate(chunk);
+        }
+    });
+    owner.join();
+    owner_exited.set_value();
+    freer.join();
+    check(fixed.stats().live_chunks == 0, "frees to an exited owner are counted");
+
+    // a new thread adopts the lists left behind and reuses their chunks
+    std::set<void*> freed(chunks.begin(), chunks.end());
+    size_t reused = 0;
+    std::thread([&] {
+        std::vector<void*> again;
+        for (int i = 0; i < 1000; ++i) {
+            again.push_back(fixed.allocate());
+            reused += freed.count(again.back());
+        }
+        for (void* chunk : again) {
+            fixed.deallocate(chunk);
+        }
+    }).join();
+    check(reused == chunks.size(), "chunks freed to an exited thread are reused");
+    fixed.trim();
+    check(fixed.stats().pools == 0, "trim releases everything after the threads exit");
+}
+
+void test_trim() {
+    FixedAllocator<120>& fixed = FixedAllocator<120>::get_instance();
+    std::vector<void*> chunks;
+    for (int i = 0; i < 5000; ++i) {
+        chunks.push_back(fixed.allocate());
+    }
+    AllocatorStats stats = fixed.stats();
+    check(stats.pools > 1 && stats.live_chunks == 5000, "pools grow with the live chunks");
+    for (void* chunk : chunks) {
+        fixed.deallocate(chunk);
+    }
+    fixed.trim();
+    stats = fixed.stats();
+    check(stats.pools == 0 && stats.pool_bytes == 0, "trim releases the empty pools");
+    check(stats.peak_bytes >= 5000 * 120, "peak bytes survive trim");
+
+    void* kept = fixed.allocate();
+    fixed.deallocate(kept);
+    check(fixed.allocate() == kept, "a freed chunk is reused from the thread cache");
+    fixed.trim();
+    check(fixed.stats().pools == 1, "trim keeps a pool with live chunks");
+    fixed.deallocate(kept);
+    fixed.trim();
+}
+
+void test_size_classes() {
+    using SizeClasses = SizeClassTable<1024>;
+    check(SizeClasses::chunk_size(SizeClasses::COUNT - 1) == 1024, "largest class is the limit");
+    for (size_t i = 1; i < SizeClasses::COUNT; ++i) {
+        check(SizeClasses::chunk_size(i) > SizeClasses::chunk_size(i - 1), "classes grow");
+        check(SizeClasses::chunk_size(i) % 8 == 0, "classes are multiples of the quantum");
+    }
+    for (size_t bytes = 1; bytes <= 1024; ++bytes) {
+        size_t index = SizeClasses::index(bytes);
+        check(SizeClasses::chunk_size(index) >= bytes, "class fits the request");
+        check(index == 0 || SizeClasses::chunk_size(index - 1) < bytes, "smallest class that fits");
+        check(SizeClasses::round_up(bytes) == SizeClasses::chunk_size(index), "round_up agrees");
+        check(SizeClasses::chunk_size(index) <= bytes + bytes / 4 + 8, "bounded internal waste");
+
+        unsigned char* ptr = static_cast<unsigned char*>(SizeClasses::allocate(bytes));
+        std::memset(ptr, 0xab, bytes);
+        SizeClasses::deallocate(ptr, bytes);
+    }
+}
+
+void test_over_aligned() {
+    FastAllocator<char, 64> alloc;
+    std::vector<std::pair<char*, size_t>> blocks;
+    for (size_t n = 1; n <= 1100; n += 7) {
+        char* ptr = alloc.allocate(n);
+        check(reinterpret_cast<uintptr_t>(ptr) % 64 == 0, "minAlignment is honoured");
+        std::memset(ptr, n & 0xff, n);
+        blocks.emplace_back(ptr, n);
+    }
+    for (auto& [ptr, n] : blocks) {
+        check(std::count(ptr, ptr + n, char(n & 0xff)) == ptrdiff_t(n), "aligned blocks do not overlap");
+        alloc.deallocate(ptr, n);
+    }
+
+    FastAllocator<char, 256> wide;
+    char* ptr = wide.allocate(1);
+    check(reinterpret_cast<uintptr_t>(ptr) % 256 == 0, "alignment above the pool alignment");
+    wide.deallocate(ptr, 1);
+
+    std::vector<int, CacheLineAllocator<int>> vector;
+    for (int i = 0; i < 1000; ++i) {
+        vector.push_back(i);
+        check(reinterpret_cast<uintptr_t>(vector.data()) % 64 == 0, "cache line aligned storage");
+    }
+}
+
+void test_bulk() {
+    FixedAllocator<136>& fixed = FixedAllocator<136>::get_instance();
+    std::vector<void*> chunks(300);
+    fixed.allocate_bulk(chunks.size(), chunks.data(), true);
+    size_t scattered = 0;
+    for (size_t i = 1; i < chunks.size(); ++i) {
+        scattered += static_cast<char*>(chunks[i]) != static_cast<char*>(chunks[i - 1]) + 136;
+    }
+    check(scattered <= 2, "contiguous bulk allocation");
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        std::memset(chunks[i], i & 0xff, 136);
+    }
+    std::set<void*> distinct(chunks.begin(), chunks.end());
+    check(distinct.size() == chunks.size(), "bulk chunks are distinct");
+    check(fixed.stats().live_chunks == 300, "bulk allocations are counted");
+
+    // half of the chunks go back from another thread
+    std::thread([&] {
+        fixed.deallocate_bulk(chunks.data(), 150);
+    }).join();
+    fixed.deallocate_bulk(chunks.data() + 150, 150);
+    check(fixed.stats().live_chunks == 0, "bulk frees are counted");
+
+    std::vector<void*> again(40);
+    fixed.allocate_bulk(again.size(), again.data());
+    for (void* chunk : again) {
+        std::memset(chunk, 0, 136);
+    }
+    fixed.deallocate_bulk(again.data(), again.size());
+    fixed.trim();
+    check(fixed.stats().pools == 0, "remote bulk frees are released by trim");
+}
+
+void test_bulk_from_partial_cache() {
+    FixedAllocator<152>& fixed = FixedAllocator<152>::get_instance();
+    std::vector<void*> singles;
+    for (int i = 0; i < 10; ++i) {
+        singles.push_back(fixed.allocate());
+    }
+    void* probe = fixed.allocate();
+    fixed.deallocate(probe);
+
+    std::vector<void*> cached(100);
+    fixed.allocate_bulk(cached.size(), cached.data());
+    check(cached[0] == probe, "bulk allocation takes the cached chunks first");
+    std::set<void*> distinct(cached.begin(), cached.end());
+    distinct.insert(singles.begin(), singles.end());
+    check(distinct.size() == 110, "cached and pool chunks are distinct");
+
+    void* next = fixed.allocate();
+    fixed.deallocate(next);
+    std::vector<void*> contiguous(100);
+    fixed.allocate_bulk(contiguous.size(), contiguous.data(), true);
+    size_t scattered = 0;
+    for (size_t i = 1; i < contiguous.size(); ++i) {
+        scattered += static_cast<char*>(contiguous[i]) != static_cast<char*>(contiguous[i - 1]) + 152;
+    }
+    check(scattered <= 2 && std::count(contiguous.begin(), contiguous.end(), next) == 0,
+            "a contiguous request skips a partly used cache");
+    check(fixed.stats().live_chunks == 210, "bulk allocations are counted once");
+
+    fixed.deallocate_bulk(contiguous.data(), contiguous.size());
+    fixed.deallocate_bulk(cached.data(), cached.size());
+    fixed.deallocate_bulk(singles.data(), singles.size());
+    fixed.trim();
+    check(fixed.stats().live_chunks == 0 && fixed.stats().pools == 0, "bulk frees return everything");
+}
+
+void test_stats() {
+    using Alloc = FastAllocator<long>;
+    auto find_row = [](size_t chunk_size) {
+        for (const AllocatorStats& row : Alloc::stats()) {
+            if (row.chunk_size == chunk_size) return row;
+        }
+        return AllocatorStats();
+    };
+    AllocatorStats before = find_row(8);
+    AllocatorStats fallback_before = Alloc::stats().back();
+    Alloc alloc;
+    std::vector<long*> values;
+    for (int i = 0; i < 100; ++i) {
+        values.push_back(alloc.allocate(1));
+    }
+    long* large = alloc.allocate(FAST_ALLOCATOR_MAX_SMALL_SIZE);
+    AllocatorStats during = find_row(8);
+    check(during.allocations == before.allocations + 100, "allocations by size class");
+    check(during.live_chunks == before.live_chunks + 100 && during.pools > 0, "live chunks");
+    check(Alloc::stats().back().allocations == fallback_before.allocations + 1,
+            "large requests are counted as operator new");
+
+    alloc.deallocate(large, FAST_ALLOCATOR_MAX_SMALL_SIZE);
+    for (long* value : values) {
+        alloc.deallocate(value, 1);
+    }
+    AllocatorStats after = find_row(8);
+    check(after.frees == before.frees + 100 && after.live_chunks == before.live_chunks,
+            "frees by size class");
+    check(Alloc::stats().back().live_chunks == fallback_before.live_chunks, "operator new frees");
+
+    std::ostringstream out;
+    Alloc::dump_stats(out);
+    check(out.str().rfind("chunk_size,allocations,frees", 0) == 0 &&
+            out.str().find("\noperator_new,") != std::string::npos, "dump_stats csv");
+}
+
+int main() {
+    test_arena();
+    test_arena_allocator();
+    test_fast_memory_resource();
+    test_trim_between_remote_frees();
+    test_thread_caches();
+    test_remote_frees();
+    test_abandoned_lists();
+    test_trim();
+    test_size_classes();
+    test_over_aligned();
+    test_bulk();
+    test_bulk_from_partial_cache();
+    test_stats();
+    std::cout << "fastallocator_test: ok" << std::endl;
+    return 0;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "list.h"
 
 // *****
@@ -6,70 +8,98 @@
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(const Allocator& _alloc): _alloc(_alloc), _size(0) {
-    _base = AllocTraits::allocate(this->_alloc, 1);
-    _base->next = _base->prev = _base;
+    _base.next = _base.prev = &_base;
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(size_t count): _alloc(Allocator()), _size(0) {
-    _base = AllocTraits::allocate(this->_alloc, 1);
-    _base->next = _base->prev = _base;
-    for (size_t i = 0; i < count; ++i) {
-        insert(begin());
-    }
+    _base.next = _base.prev = &_base;
+    append_nodes(count, [this](Node* node) { AllocTraits::construct(this->_alloc, node); });
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::List(size_t count, const T& value, const Allocator& _alloc):
         _alloc(_alloc), _size(0) {
-    _base = AllocTraits::allocate(this->_alloc, 1);
-    _base->next = _base->prev = _base;
-    for (size_t i = 0; i < count; ++i) {
-        insert(begin(), value);
-    }
+    _base.next = _base.prev = &_base;
+    append_nodes(count, [this, &value](Node* node) {
+        AllocTraits::construct(this->_alloc, node, value);
+    });
 }
 
 template<typename T, typename Allocator>
-List<T, Allocator>::List(const List& another): _size(0) {
-    _alloc = AllocTraits::select_on_container_copy_construction(another._alloc);
+template<typename InputIterator, typename>
+List<T, Allocator>::List(InputIterator first, InputIterator last, const Allocator& _alloc):
+        _alloc(_alloc), _size(0) {
+    _base.next = _base.prev = &_base;
+    using Category = typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        append_nodes(std::distance(first, last), [this, &first](Node* node) {
+            AllocTraits::construct(this->_alloc, node, *first);
+            ++first;
+        });
+    } else {
+        for ( ; first != last; ++first) {
+            push_back(*first);
+        }
+    }
+}
 
-    _base = AllocTraits::allocate(_alloc, 1);
-    _base->next = _base->prev = _base;
+template<typename T, typename Allocator>
+List<T, Allocator>::List(const List& another):
+        _alloc(AllocTraits::select_on_container_copy_construction(another._alloc)), _size(0) {
+    _base.next = _base.prev = &_base;
     iterator it = another.begin();
-    while (it != another.end()) {
-        push_back(*it);
+    append_nodes(another._size, [this, &it](Node* node) {
+        AllocTraits::construct(_alloc, node, *it);
         ++it;
-    }
+    });
+}
+
+template<typename T, typename Allocator>
+List<T, Allocator>::List(List&& another) noexcept: _alloc(another._alloc), _size(0) {
+    _base.next = _base.prev = &_base;
+    steal(another);
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>& List<T, Allocator>::operator=(const List& another) {
-    if (another._base == _base) return *this;
-    while (_size != 0) {
-        erase(begin());
-    }
-    AllocTraits::deallocate(_alloc, _base, 1);
+    if (&another == this) return *this;
+    clear_nodes();
 
-    if (AllocTraits::propagate_on_container_copy_assignment::value) {
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
         _alloc = another._alloc;
     }
 
-    _base = AllocTraits::allocate(_alloc, 1);
-    _base->next = _base->prev = _base;
     iterator it = another.begin();
-    while (it != another.end()) {
-        push_back(*it);
+    append_nodes(another._size, [this, &it](Node* node) {
+        AllocTraits::construct(_alloc, node, *it);
         ++it;
+    });
+    return *this;
+}
+
+template<typename T, typename Allocator>
+List<T, Allocator>& List<T, Allocator>::operator=(List&& another) {
+    if (&another == this) return *this;
+    clear_nodes();
+
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        _alloc = another._alloc;
+    } else if (_alloc != another._alloc) {
+        while (another._size != 0) {
+            emplace(end(), std::move(*another.begin()));
+            another.erase(another.begin());
+        }
+        return *this;
     }
+
+    steal(another);
     return *this;
 }
 
 template<typename T, typename Allocator>
 List<T, Allocator>::~List() {
-    while (_size != 0) {
-        erase(begin());
-    }
-    AllocTraits::deallocate(_alloc, _base, 1);
+    clear_nodes();
 }
 
 // *****
@@ -91,11 +121,33 @@ void List<T, Allocator>::push_back(const T& value) {
     insert(end(), value);
 }
 
+template <typename T, typename Allocator>
+void List<T, Allocator>::push_back(T&& value) {
+    insert(end(), std::move(value));
+}
+
 template <typename T, typename Allocator>
 void List<T, Allocator>::push_front(const T& value) {
     insert(begin(), value);
 }
 
+template <typename T, typename Allocator>
+void List<T, Allocator>::push_front(T&& value) {
+    insert(begin(), std::move(value));
+}
+
+template <typename T, typename Allocator>
+template<typename... Args>
+T& List<T, Allocator>::emplace_back(Args&&... args) {
+    return *emplace(end(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename Allocator>
+template<typename... Args>
+T& List<T, Allocator>::emplace_front(Args&&... args) {
+    return *emplace(begin(), std::forward<Args>(args)...);
+}
+
 template <typename T, typename Allocator>
 void List<T, Allocator>::pop_back() {
     erase(--end());
@@ -106,46 +158,51 @@ void List<T, Allocator>::pop_front() {
     erase(begin());
 }
 
+template<typename T, typename Allocator>
+void List<T, Allocator>::clear() {
+    clear_nodes();
+}
+
 // *****
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::iterator List<T, Allocator>::begin() const {
-    return iterator(_base->next);
+    return iterator(_base.next);
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::iterator List<T, Allocator>::end() const {
-    return iterator(_base);
+    return iterator(const_cast<NodeBase*>(&_base));
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::const_iterator List<T, Allocator>::cbegin() const {
-    return const_iterator(_base->next);
+    return const_iterator(_base.next);
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::const_iterator List<T, Allocator>::cend() const {
-    return const_iterator(_base);
+    return const_iterator(const_cast<NodeBase*>(&_base));
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::reverse_iterator List<T, Allocator>::rbegin() const {
-    return reverse_iterator(_base);
+    return reverse_iterator(end());
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::reverse_iterator List<T, Allocator>::rend() const {
-    return reverse_iterator(_base->next);
+    return reverse_iterator(begin());
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::const_reverse_iterator List<T, Allocator>::crbegin() const {
-    return const_reverse_iterator(_base);
+    return const_reverse_iterator(cend());
 }
 
 template<typename T, typename Allocator>
 typename List<T, Allocator>::const_reverse_iterator List<T, Allocator>::crend() const {
-    return const_reverse_iterator(_base->next);
+    return const_reverse_iterator(cbegin());
 }
 
 // *****
@@ -153,27 +210,52 @@ typename List<T, Allocator>::const_reverse_iterator List<T, Allocator>::crend()
 template<typename T, typename Allocator>
 template<bool isConst>
 typename List<T, Allocator>::iterator List<T, Allocator>::insert(common_iterator<isConst> it, const T& value) {
+    return emplace(it, value);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename List<T, Allocator>::iterator List<T, Allocator>::insert(common_iterator<isConst> it, T&& value) {
+    return emplace(it, std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, typename... Args>
+typename List<T, Allocator>::iterator List<T, Allocator>::emplace(common_iterator<isConst> it, Args&&... args) {
     Node* node = AllocTraits::allocate(_alloc, 1);
-    AllocTraits::construct(_alloc, node, value);
-    node->prev = it.adress->prev;
-    node->next = it.adress;
-    it.adress->prev = node;
-    node->prev->next = node;
-    ++_size;
+    try {
+        AllocTraits::construct(_alloc, node, std::forward<Args>(args)...);
+    } catch (...) {
+        AllocTraits::deallocate(_alloc, node, 1);
+        throw;
+    }
+    link(it.adress, node);
     return iterator(node);
 }
 
+template<typename T, typename Allocator>
+template<bool isConst>
+typename List<T, Allocator>::iterator List<T, Allocator>::insert(common_iterator<isConst> it,
+        node_type&& node) {
+    if (node.empty()) return end();
+    if constexpr (!AllocTraits::is_always_equal::value) {
+        if (_alloc != *node.alloc) {
+            iterator ret = emplace(it, std::move(node.value()));
+            node.reset();
+            return ret;
+        }
+    }
+    Node* adress = node.node;
+    node.node = nullptr;
+    node.alloc.reset();
+    link(it.adress, adress);
+    return iterator(adress);
+}
+
 template<typename T, typename Allocator>
 template<bool isConst>
 typename List<T, Allocator>::iterator List<T, Allocator>::insert(common_iterator<isConst> it) {
-    Node* node = AllocTraits::allocate(_alloc, 1);
-    AllocTraits::construct(_alloc, node);
-    node->prev = it.adress->prev;
-    node->next = it.adress;
-    it.adress->prev = node;
-    node->prev->next = node;
-    ++_size;
-    return iterator(node);
+    return emplace(it);
 }
 
 template<typename T, typename Allocator>
@@ -181,9 +263,275 @@ template<bool isConst>
 void List<T, Allocator>::erase(common_iterator<isConst> it) {
     it.adress->next->prev = it.adress->prev;
     it.adress->prev->next = it.adress->next;
-    AllocTraits::destroy(_alloc, it.adress);
-    AllocTraits::deallocate(_alloc, it.adress, 1);
+    Node* node = static_cast<Node*>(it.adress);
+    AllocTraits::destroy(_alloc, node);
+    AllocTraits::deallocate(_alloc, node, 1);
+    --_size;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename List<T, Allocator>::node_type List<T, Allocator>::extract(common_iterator<isConst> it) {
+    it.adress->next->prev = it.adress->prev;
+    it.adress->prev->next = it.adress->next;
     --_size;
+    return node_type(static_cast<Node*>(it.adress), _alloc);
+}
+
+// *****
+
+template<typename T, typename Allocator>
+template<bool isConst>
+void List<T, Allocator>::splice(common_iterator<isConst> it, List& another) {
+    if (&another == this) return;
+    transfer(it.adress, another._base.next, &another._base, another, another._size);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, bool isConst1>
+void List<T, Allocator>::splice(common_iterator<isConst> it, List& another,
+        common_iterator<isConst1> element) {
+    transfer(it.adress, element.adress, element.adress->next, another, 1);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, bool isConst1>
+void List<T, Allocator>::splice(common_iterator<isConst> it, List& another,
+        common_iterator<isConst1> first, common_iterator<isConst1> last) {
+    size_t count = &another == this ? 0 : std::distance(first, last);
+    transfer(it.adress, first.adress, last.adress, another, count);
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+void List<T, Allocator>::merge(List& another, Compare comp) {
+    if (&another == this) return;
+    NodeBase* mine = _base.next;
+    NodeBase* theirs = another._base.next;
+    while (theirs != &another._base) {
+        if (mine == &_base) {
+            transfer(&_base, theirs, &another._base, another, another._size);
+            return;
+        }
+        const T& value = static_cast<Node*>(mine)->value;
+        if (!comp(static_cast<Node*>(theirs)->value, value)) {
+            mine = mine->next;
+            continue;
+        }
+        NodeBase* run_end = theirs->next;
+        size_t count = 1;
+        while (run_end != &another._base && comp(static_cast<Node*>(run_end)->value, value)) {
+            run_end = run_end->next;
+            ++count;
+        }
+        transfer(mine, theirs, run_end, another, count);
+        theirs = run_end;
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+void List<T, Allocator>::sort(Compare comp) {
+    if (_size < 2) return;
+    NodeBase* bins[64] = {};
+    size_t used = 0;
+    for (NodeBase* node = _base.next; node != &_base; ) {
+        NodeBase* carry = node;
+        node = node->next;
+        carry->next = nullptr;
+        size_t i = 0;
+        for ( ; bins[i] != nullptr; ++i) {
+            carry = merge_chains(bins[i], carry, comp);
+            bins[i] = nullptr;
+        }
+        bins[i] = carry;
+        used = std::max(used, i + 1);
+    }
+
+    NodeBase* sorted = nullptr;
+    for (size_t i = 0; i < used; ++i) {
+        if (bins[i] != nullptr) {
+            sorted = sorted == nullptr ? bins[i] : merge_chains(bins[i], sorted, comp);
+        }
+    }
+
+    NodeBase* prev = &_base;
+    for (NodeBase* node = sorted; node != nullptr; node = node->next) {
+        node->prev = prev;
+        prev->next = node;
+        prev = node;
+    }
+    prev->next = &_base;
+    _base.prev = prev;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::defragment() {
+    Node* batch[BULK_BATCH_SIZE];
+    Node* old[BULK_BATCH_SIZE];
+    NodeBase* node = _base.next;
+    for (size_t left = _size; left > 0; ) {
+        size_t taken = std::min(left, BULK_BATCH_SIZE);
+        allocate_nodes(taken, batch, true);
+        size_t i = 0;
+        try {
+            for ( ; i < taken; ++i, node = node->next) {
+                old[i] = static_cast<Node*>(node);
+                AllocTraits::construct(_alloc, batch[i], std::move_if_noexcept(old[i]->value));
+            }
+        } catch (...) {
+            for (size_t j = 0; j < i; ++j) {
+                AllocTraits::destroy(_alloc, batch[j]);
+            }
+            deallocate_nodes(batch, taken);
+            throw;
+        }
+        for (i = 0; i < taken; ++i) {
+            batch[i]->prev = old[i]->prev;
+            batch[i]->next = old[i]->next;
+            batch[i]->prev->next = batch[i];
+            batch[i]->next->prev = batch[i];
+            AllocTraits::destroy(_alloc, old[i]);
+        }
+        deallocate_nodes(old, taken);
+        left -= taken;
+    }
+}
+
+// *****
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::allocate_nodes(size_t count, Node** nodes, bool contiguous) {
+    if constexpr (has_bulk_allocation<NodeAlloc>::value) {
+        _alloc.allocate_bulk(count, nodes, contiguous);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            nodes[i] = AllocTraits::allocate(_alloc, 1);
+        }
+    }
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::deallocate_nodes(Node** nodes, size_t count) {
+    if constexpr (has_bulk_allocation<NodeAlloc>::value) {
+        _alloc.deallocate_bulk(nodes, count);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            AllocTraits::deallocate(_alloc, nodes[i], 1);
+        }
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Construct>
+void List<T, Allocator>::append_nodes(size_t count, Construct construct) {
+    Node* batch[BULK_BATCH_SIZE];
+    while (count > 0) {
+        size_t taken = std::min(count, BULK_BATCH_SIZE);
+        allocate_nodes(taken, batch, taken == BULK_BATCH_SIZE);
+        for (size_t i = 0; i < taken; ++i) {
+            try {
+                construct(batch[i]);
+            } catch (...) {
+                deallocate_nodes(batch + i, taken - i);
+                throw;
+            }
+            batch[i]->prev = _base.prev;
+            batch[i]->next = &_base;
+            _base.prev->next = batch[i];
+            _base.prev = batch[i];
+            ++_size;
+        }
+        count -= taken;
+    }
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::clear_nodes() {
+    Node* batch[BULK_BATCH_SIZE];
+    size_t count = 0;
+    for (NodeBase* node = _base.next; node != &_base; ) {
+        NodeBase* next = node->next;
+        batch[count] = static_cast<Node*>(node);
+        AllocTraits::destroy(_alloc, batch[count++]);
+        if (count == BULK_BATCH_SIZE) {
+            deallocate_nodes(batch, count);
+            count = 0;
+        }
+        node = next;
+    }
+    if (count != 0) {
+        deallocate_nodes(batch, count);
+    }
+    _base.next = _base.prev = &_base;
+    _size = 0;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::steal(List& another) {
+    if (another._size == 0) return;
+    _base.next = another._base.next;
+    _base.prev = another._base.prev;
+    _base.next->prev = _base.prev->next = &_base;
+    _size = another._size;
+    another._base.next = another._base.prev = &another._base;
+    another._size = 0;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::transfer(NodeBase* position, NodeBase* first, NodeBase* last,
+        List& another, size_t count) {
+    if (first == last || position == first || position == last) return;
+    if constexpr (!AllocTraits::is_always_equal::value) {
+        if (_alloc != another._alloc) {
+            while (first != last) {
+                NodeBase* next = first->next;
+                emplace(iterator(position), std::move(static_cast<Node*>(first)->value));
+                another.erase(iterator(first));
+                first = next;
+            }
+            return;
+        }
+    }
+
+    NodeBase* tail = last->prev;
+    first->prev->next = last;
+    last->prev = first->prev;
+    first->prev = position->prev;
+    tail->next = position;
+    position->prev->next = first;
+    position->prev = tail;
+    _size += count;
+    another._size -= count;
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::link(NodeBase* position, NodeBase* node) {
+    node->prev = position->prev;
+    node->next = position;
+    position->prev->next = node;
+    position->prev = node;
+    ++_size;
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+typename List<T, Allocator>::NodeBase* List<T, Allocator>::merge_chains(NodeBase* first,
+        NodeBase* second, Compare& comp) {
+    NodeBase* head = nullptr;
+    NodeBase** tail = &head;
+    while (first != nullptr && second != nullptr) {
+        if (comp(static_cast<Node*>(second)->value, static_cast<Node*>(first)->value)) {
+            *tail = second;
+            second = second->next;
+        } else {
+            *tail = first;
+            first = first->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = first != nullptr ? first : second;
+    return head;
 }
 
 // *****
@@ -195,7 +543,7 @@ List<T, Allocator>::common_iterator<isConst>::common_iterator() {}
 
 template<typename T, typename Allocator>
 template<bool isConst>
-List<T, Allocator>::common_iterator<isConst>::common_iterator(Node* x): adress(x) {}
+List<T, Allocator>::common_iterator<isConst>::common_iterator(NodeBase* x): adress(x) {}
 
 template<typename T, typename Allocator>
 template<bool isConst>
@@ -216,13 +564,13 @@ bool List<T, Allocator>::common_iterator<isConst>::operator!=(List<T, Allocator>
 template<typename T, typename Allocator>
 template<bool isConst>
 std::conditional_t<isConst, const T&, T&> List<T, Allocator>::common_iterator<isConst>::operator*() {
-    return adress->value;
+    return static_cast<Node*>(adress)->value;
 }
 
 template<typename T, typename Allocator>
 template<bool isConst>
 std::conditional_t<isConst, const T*, T*> List<T, Allocator>::common_iterator<isConst>::operator->() {
-    return &(adress->value);
+    return &(static_cast<Node*>(adress)->value);
 }
 
 template<typename T, typename Allocator>
@@ -255,14 +603,1663 @@ List<T, Allocator>::template common_iterator<isConst> List<T, Allocator>::common
     return ret;
 }
 
+// *****
+// List::node_type
+
+template<typename T, typename Allocator>
+List<T, Allocator>::node_type::node_type(): node(nullptr) {}
+
+template<typename T, typename Allocator>
+List<T, Allocator>::node_type::node_type(Node* node, const NodeAlloc& alloc): node(node), alloc(alloc) {}
+
+template<typename T, typename Allocator>
+List<T, Allocator>::node_type::node_type(node_type&& another): node(another.node), alloc(another.alloc) {
+    another.node = nullptr;
+    another.alloc.reset();
+}
+
+template<typename T, typename Allocator>
+typename List<T, Allocator>::node_type& List<T, Allocator>::node_type::operator=(node_type&& another) {
+    if (&another == this) return *this;
+    reset();
+    node = another.node;
+    alloc = another.alloc;
+    another.node = nullptr;
+    another.alloc.reset();
+    return *this;
+}
+
+template<typename T, typename Allocator>
+List<T, Allocator>::node_type::~node_type() {
+    reset();
+}
+
+template<typename T, typename Allocator>
+bool List<T, Allocator>::node_type::empty() const {
+    return node == nullptr;
+}
+
+template<typename T, typename Allocator>
+List<T, Allocator>::node_type::operator bool() const {
+    return node != nullptr;
+}
+
+template<typename T, typename Allocator>
+T& List<T, Allocator>::node_type::value() const {
+    return node->value;
+}
+
+template<typename T, typename Allocator>
+Allocator List<T, Allocator>::node_type::get_allocator() const {
+    return Allocator(*alloc);
+}
+
+template<typename T, typename Allocator>
+void List<T, Allocator>::node_type::reset() {
+    if (node == nullptr) return;
+    AllocTraits::destroy(*alloc, node);
+    AllocTraits::deallocate(*alloc, node, 1);
+    node = nullptr;
+    alloc.reset();
+}
+
 // *****
 // List::Node
 
 template<typename T, typename Allocator>
-List<T, Allocator>::Node::Node(): next(this), prev(this) {}
+List<T, Allocator>::Node::Node(): NodeBase{this, this} {}
 
 template<typename T, typename Allocator>
-List<T, Allocator>::Node::Node(const T& value): value(value), next(this), prev(this) {}
+List<T, Allocator>::Node::Node(const T& value): NodeBase{this, this}, value(value) {}
 
 template<typename T, typename Allocator>
-List<T, Allocator>::Node::Node(const List<T, Allocator>::Node& another): value(another.value), next(nullptr), prev(nullptr) {}
+List<T, Allocator>::Node::Node(const List<T, Allocator>::Node& another): NodeBase{nullptr, nullptr}, value(another.value) {}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+List<T, Allocator>::Node::Node(Args&&... args):
+        NodeBase{this, this}, value(std::forward<Args>(args)...) {}
+
+// *****
+// UNROLLED LIST
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>::UnrolledList(const Allocator& _alloc):
+        _base{&_base, &_base, 0}, _alloc(_alloc), _value_alloc(_alloc), _size(0) {}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>::UnrolledList(const UnrolledList& another):
+        _base{&_base, &_base, 0},
+        _alloc(AllocTraits::select_on_container_copy_construction(another._alloc)),
+        _value_alloc(_alloc), _size(0) {
+    for (const T& value : another) {
+        emplace_back(value);
+    }
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>::UnrolledList(UnrolledList&& another) noexcept:
+        _base{&_base, &_base, 0}, _alloc(another._alloc), _value_alloc(another._value_alloc),
+        _size(0) {
+    steal(another);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>& UnrolledList<T, Allocator, blockCapacity>::operator=(
+        const UnrolledList& another) {
+    if (&another == this) return *this;
+    clear_blocks();
+
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+        _alloc = another._alloc;
+        _value_alloc = another._value_alloc;
+    }
+
+    for (const T& value : another) {
+        emplace_back(value);
+    }
+    return *this;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>& UnrolledList<T, Allocator, blockCapacity>::operator=(
+        UnrolledList&& another) noexcept(
+        std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+        std::allocator_traits<Allocator>::is_always_equal::value) {
+    if (&another == this) return *this;
+    clear_blocks();
+
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        _alloc = another._alloc;
+        _value_alloc = another._value_alloc;
+    } else if (_alloc != another._alloc) {
+        for (T& value : another) {
+            emplace_back(std::move(value));
+        }
+        another.clear();
+        return *this;
+    }
+
+    steal(another);
+    return *this;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+UnrolledList<T, Allocator, blockCapacity>::~UnrolledList() {
+    clear_blocks();
+}
+
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+Allocator UnrolledList<T, Allocator, blockCapacity>::get_allocator() const {
+    return _value_alloc;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+size_t UnrolledList<T, Allocator, blockCapacity>::size() const {
+    return _size;
+}
+
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::push_back(const T& value) {
+    emplace(end(), value);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::push_back(T&& value) {
+    emplace(end(), std::move(value));
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::push_front(const T& value) {
+    emplace(begin(), value);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::push_front(T&& value) {
+    emplace(begin(), std::move(value));
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<typename... Args>
+T& UnrolledList<T, Allocator, blockCapacity>::emplace_back(Args&&... args) {
+    return *emplace(end(), std::forward<Args>(args)...);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<typename... Args>
+T& UnrolledList<T, Allocator, blockCapacity>::emplace_front(Args&&... args) {
+    return *emplace(begin(), std::forward<Args>(args)...);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::pop_back() {
+    erase(--end());
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::pop_front() {
+    erase(begin());
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::clear() {
+    clear_blocks();
+}
+
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::begin() const {
+    return iterator(_base.next, 0);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::end() const {
+    return iterator(const_cast<BlockBase*>(&_base), 0);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::const_iterator
+        UnrolledList<T, Allocator, blockCapacity>::cbegin() const {
+    return const_iterator(_base.next, 0);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::const_iterator
+        UnrolledList<T, Allocator, blockCapacity>::cend() const {
+    return const_iterator(const_cast<BlockBase*>(&_base), 0);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::reverse_iterator
+        UnrolledList<T, Allocator, blockCapacity>::rbegin() const {
+    return reverse_iterator(end());
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::reverse_iterator
+        UnrolledList<T, Allocator, blockCapacity>::rend() const {
+    return reverse_iterator(begin());
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::const_reverse_iterator
+        UnrolledList<T, Allocator, blockCapacity>::crbegin() const {
+    return const_reverse_iterator(cend());
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::const_reverse_iterator
+        UnrolledList<T, Allocator, blockCapacity>::crend() const {
+    return const_reverse_iterator(cbegin());
+}
+
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::insert(common_iterator<isConst> it, const T& value) {
+    return emplace(it, value);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::insert(common_iterator<isConst> it, T&& value) {
+    return emplace(it, std::move(value));
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst, typename... Args>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::emplace(common_iterator<isConst> it, Args&&... args) {
+    BlockBase* block = it.block;
+    size_t index = it.index;
+    if (index == 0 && block->prev != &_base &&
+            (block == &_base || block->prev->count < blockCapacity)) {
+        block = block->prev;
+        index = block->count;
+    }
+
+    if (block == &_base) {
+        block = allocate_block(_base.next);
+    } else if (block->count == blockCapacity) {
+        if (index == blockCapacity) {
+            block = allocate_block(block->next);
+            index = 0;
+        } else if (index == 0) {
+            block = allocate_block(block);
+        } else {
+            BlockBase* half = allocate_block(block->next);
+            half->count = block->count / 2;
+            block->count -= half->count;
+            relocate(block, block->count, half, 0, half->count);
+            if (index > block->count) {
+                index -= block->count;
+                block = half;
+            }
+        }
+    }
+
+    if (index == block->count) {
+        try {
+            ValueAllocTraits::construct(_value_alloc, Block::values(block) + index,
+                    std::forward<Args>(args)...);
+        } catch (...) {
+            if (block->count == 0) {
+                deallocate_block(block);
+            }
+            throw;
+        }
+    } else {
+        T value(std::forward<Args>(args)...);
+        relocate(block, index, block, index + 1, block->count - index);
+        ValueAllocTraits::construct(_value_alloc, Block::values(block) + index, std::move(value));
+    }
+    ++block->count;
+    ++_size;
+    return iterator(block, index);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::iterator
+        UnrolledList<T, Allocator, blockCapacity>::erase(common_iterator<isConst> it) {
+    BlockBase* block = it.block;
+    size_t index = it.index;
+    ValueAllocTraits::destroy(_value_alloc, Block::values(block) + index);
+    relocate(block, index + 1, block, index, block->count - index - 1);
+    --block->count;
+    --_size;
+
+    BlockBase* next = block->next;
+    if (block->count == 0) {
+        deallocate_block(block);
+        return iterator(next, 0);
+    }
+    if (next != &_base && block->count + next->count <= blockCapacity * 3 / 4) {
+        relocate(next, 0, block, block->count, next->count);
+        block->count += next->count;
+        deallocate_block(next);
+    }
+    return index < block->count ? iterator(block, index) : iterator(block->next, 0);
+}
+
+// *****
+
+template<typename T, typename Allocator, size_t blockCapacity>
+typename UnrolledList<T, Allocator, blockCapacity>::Block*
+        UnrolledList<T, Allocator, blockCapacity>::allocate_block(BlockBase* before) {
+    Block* block = AllocTraits::allocate(_alloc, 1);
+    block->count = 0;
+    block->next = before;
+    block->prev = before->prev;
+    before->prev->next = block;
+    before->prev = block;
+    return block;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::deallocate_block(BlockBase* block) {
+    block->prev->next = block->next;
+    block->next->prev = block->prev;
+    AllocTraits::deallocate(_alloc, static_cast<Block*>(block), 1);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::relocate(BlockBase* from, size_t from_index,
+        BlockBase* to, size_t to_index, size_t count) {
+    T* source = Block::values(from) + from_index;
+    T* target = Block::values(to) + to_index;
+    if (target > source && target < source + count) {
+        for (size_t i = count; i > 0; --i) {
+            ValueAllocTraits::construct(_value_alloc, target + i - 1, std::move(source[i - 1]));
+            ValueAllocTraits::destroy(_value_alloc, source + i - 1);
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            ValueAllocTraits::construct(_value_alloc, target + i, std::move(source[i]));
+            ValueAllocTraits::destroy(_value_alloc, source + i);
+        }
+    }
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::clear_blocks() {
+    for (BlockBase* block = _base.next; block != &_base; ) {
+        BlockBase* next = block->next;
+        for (size_t i = 0; i < block->count; ++i) {
+            ValueAllocTraits::destroy(_value_alloc, Block::values(block) + i);
+        }
+        AllocTraits::deallocate(_alloc, static_cast<Block*>(block), 1);
+        block = next;
+    }
+    _base.next = _base.prev = &_base;
+    _size = 0;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+void UnrolledList<T, Allocator, blockCapacity>::steal(UnrolledList& another) {
+    if (another._size == 0) return;
+    _base.next = another._base.next;
+    _base.prev = another._base.prev;
+    _base.next->prev = _base.prev->next = &_base;
+    _size = another._size;
+    another._base.next = another._base.prev = &another._base;
+    another._size = 0;
+}
+
+// *****
+// UnrolledList::iterator
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::common_iterator() {}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::common_iterator(
+        BlockBase* block, size_t index): block(block), index(index) {}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::common_iterator(
+        const common_iterator<false>& it): block(it.block), index(it.index) {}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+bool UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator==(
+        common_iterator<isConst> x) {
+    return block == x.block && index == x.index;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+bool UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator!=(
+        common_iterator<isConst> x) {
+    return !operator==(x);
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+std::conditional_t<isConst, const T&, T&>
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator*() {
+    return Block::values(block)[index];
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+std::conditional_t<isConst, const T*, T*>
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator->() {
+    return Block::values(block) + index;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::template common_iterator<isConst>&
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator++() {
+    if (++index == block->count) {
+        block = block->next;
+        index = 0;
+    }
+    return *this;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::template common_iterator<isConst>
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator++(int) {
+    common_iterator<isConst> ret = *this;
+    ++*this;
+    return ret;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::template common_iterator<isConst>&
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator--() {
+    if (index == 0) {
+        block = block->prev;
+        index = block->count;
+    }
+    --index;
+    return *this;
+}
+
+template<typename T, typename Allocator, size_t blockCapacity>
+template<bool isConst>
+typename UnrolledList<T, Allocator, blockCapacity>::template common_iterator<isConst>
+        UnrolledList<T, Allocator, blockCapacity>::common_iterator<isConst>::operator--(int) {
+    common_iterator<isConst> ret = *this;
+    --*this;
+    return ret;
+}
+
+// *****
+// UnrolledList::Block
+
+template<typename T, typename Allocator, size_t blockCapacity>
+T* UnrolledList<T, Allocator, blockCapacity>::Block::values(BlockBase* block) {
+    return reinterpret_cast<T*>(static_cast<Block*>(block)->storage);
+}
+
+// *****
+// INTRUSIVE LIST
+// *****
+
+template<typename Tag>
+IntrusiveListHook<Tag>::IntrusiveListHook() {}
+
+template<typename Tag>
+IntrusiveListHook<Tag>::IntrusiveListHook(const IntrusiveListHook&) {}
+
+template<typename Tag>
+IntrusiveListHook<Tag>& IntrusiveListHook<Tag>::operator=(const IntrusiveListHook&) {
+    return *this;
+}
+
+template<typename Tag>
+bool IntrusiveListHook<Tag>::is_linked() const {
+    return next != nullptr;
+}
+
+// *****
+
+template<typename T, typename Tag>
+IntrusiveList<T, Tag>::IntrusiveList(): _size(0) {
+    _base.next = _base.prev = &_base;
+}
+
+template<typename T, typename Tag>
+IntrusiveList<T, Tag>::IntrusiveList(IntrusiveList&& another): _size(0) {
+    _base.next = _base.prev = &_base;
+    steal(another);
+}
+
+template<typename T, typename Tag>
+IntrusiveList<T, Tag>& IntrusiveList<T, Tag>::operator=(IntrusiveList&& another) {
+    if (&another == this) return *this;
+    clear();
+    steal(another);
+    return *this;
+}
+
+template<typename T, typename Tag>
+IntrusiveList<T, Tag>::~IntrusiveList() {
+    clear();
+}
+
+// *****
+
+template<typename T, typename Tag>
+size_t IntrusiveList<T, Tag>::size() const {
+    return _size;
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::push_back(T& x) {
+    link(&_base, &static_cast<Hook&>(x));
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::push_front(T& x) {
+    link(_base.next, &static_cast<Hook&>(x));
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::pop_back() {
+    unlink(_base.prev);
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::pop_front() {
+    unlink(_base.next);
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::remove(T& x) {
+    unlink(&static_cast<Hook&>(x));
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::clear() {
+    for (Hook* node = _base.next; node != &_base; ) {
+        Hook* next = node->next;
+        node->next = node->prev = nullptr;
+        node = next;
+    }
+    _base.next = _base.prev = &_base;
+    _size = 0;
+}
+
+// *****
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::begin() const {
+    return iterator(_base.next);
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::end() const {
+    return iterator(const_cast<Hook*>(&_base));
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::const_iterator IntrusiveList<T, Tag>::cbegin() const {
+    return const_iterator(_base.next);
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::const_iterator IntrusiveList<T, Tag>::cend() const {
+    return const_iterator(const_cast<Hook*>(&_base));
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::reverse_iterator IntrusiveList<T, Tag>::rbegin() const {
+    return reverse_iterator(end());
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::reverse_iterator IntrusiveList<T, Tag>::rend() const {
+    return reverse_iterator(begin());
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::const_reverse_iterator IntrusiveList<T, Tag>::crbegin() const {
+    return const_reverse_iterator(cend());
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::const_reverse_iterator IntrusiveList<T, Tag>::crend() const {
+    return const_reverse_iterator(cbegin());
+}
+
+template<typename T, typename Tag>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::iterator_to(T& x) const {
+    return iterator(&static_cast<Hook&>(x));
+}
+
+// *****
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::insert(common_iterator<isConst> it, T& x) {
+    link(it.adress, &static_cast<Hook&>(x));
+    return iterator(&static_cast<Hook&>(x));
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::iterator IntrusiveList<T, Tag>::erase(common_iterator<isConst> it) {
+    Hook* next = it.adress->next;
+    unlink(it.adress);
+    return iterator(next);
+}
+
+// *****
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::link(Hook* position, Hook* node) {
+    node->prev = position->prev;
+    node->next = position;
+    position->prev->next = node;
+    position->prev = node;
+    ++_size;
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::unlink(Hook* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->next = node->prev = nullptr;
+    --_size;
+}
+
+template<typename T, typename Tag>
+void IntrusiveList<T, Tag>::steal(IntrusiveList& another) {
+    if (another._size == 0) return;
+    _base.next = another._base.next;
+    _base.prev = another._base.prev;
+    _base.next->prev = _base.prev->next = &_base;
+    _size = another._size;
+    another._base.next = another._base.prev = &another._base;
+    another._size = 0;
+}
+
+// *****
+// IntrusiveList::iterator
+
+template<typename T, typename Tag>
+template<bool isConst>
+IntrusiveList<T, Tag>::common_iterator<isConst>::common_iterator() {}
+
+template<typename T, typename Tag>
+template<bool isConst>
+IntrusiveList<T, Tag>::common_iterator<isConst>::common_iterator(Hook* x): adress(x) {}
+
+template<typename T, typename Tag>
+template<bool isConst>
+IntrusiveList<T, Tag>::common_iterator<isConst>::common_iterator(const common_iterator<false>& it): adress(it.adress) {}
+
+template<typename T, typename Tag>
+template<bool isConst>
+bool IntrusiveList<T, Tag>::common_iterator<isConst>::operator==(common_iterator<isConst> x) {
+    return adress == x.adress;
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+bool IntrusiveList<T, Tag>::common_iterator<isConst>::operator!=(common_iterator<isConst> x) {
+    return !operator==(x);
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+std::conditional_t<isConst, const T&, T&> IntrusiveList<T, Tag>::common_iterator<isConst>::operator*() {
+    return static_cast<T&>(*adress);
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+std::conditional_t<isConst, const T*, T*> IntrusiveList<T, Tag>::common_iterator<isConst>::operator->() {
+    return &static_cast<T&>(*adress);
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::template common_iterator<isConst>& IntrusiveList<T, Tag>::common_iterator<isConst>::operator++() {
+    adress = adress->next;
+    return *this;
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::template common_iterator<isConst> IntrusiveList<T, Tag>::common_iterator<isConst>::operator++(int) {
+    common_iterator<isConst> ret = *this;
+    adress = adress->next;
+    return ret;
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::template common_iterator<isConst>& IntrusiveList<T, Tag>::common_iterator<isConst>::operator--() {
+    adress = adress->prev;
+    return *this;
+}
+
+template<typename T, typename Tag>
+template<bool isConst>
+typename IntrusiveList<T, Tag>::template common_iterator<isConst> IntrusiveList<T, Tag>::common_iterator<isConst>::operator--(int) {
+    common_iterator<isConst> ret = *this;
+    adress = adress->prev;
+    return ret;
+}
+
+// *****
+// COMPACT LIST
+// *****
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::CompactList(const Allocator& _alloc):
+        _alloc(_alloc), _value_alloc(_alloc) {
+    create_storage();
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::CompactList(size_t count): CompactList() {
+    reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        emplace_back();
+    }
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::CompactList(size_t count, const T& value, const Allocator& _alloc):
+        CompactList(_alloc) {
+    reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        emplace_back(value);
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename InputIterator, typename>
+CompactList<T, Allocator>::CompactList(InputIterator first, InputIterator last,
+        const Allocator& _alloc): CompactList(_alloc) {
+    using Category = typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        reserve(std::distance(first, last));
+    }
+    for ( ; first != last; ++first) {
+        emplace_back(*first);
+    }
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::CompactList(const CompactList& another):
+        CompactList(ValueAllocTraits::select_on_container_copy_construction(
+                another._value_alloc)) {
+    reserve(another._size);
+    for (const T& value : another) {
+        emplace_back(value);
+    }
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::CompactList(CompactList&& another):
+        _alloc(another._alloc), _value_alloc(another._value_alloc) {
+    steal(another);
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>& CompactList<T, Allocator>::operator=(const CompactList& another) {
+    if (&another == this) return *this;
+    clear_slots();
+
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
+        destroy_storage();
+        _alloc = another._alloc;
+        _value_alloc = another._value_alloc;
+        create_storage();
+    }
+
+    reserve(another._size);
+    for (const T& value : another) {
+        emplace_back(value);
+    }
+    return *this;
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>& CompactList<T, Allocator>::operator=(CompactList&& another) {
+    if (&another == this) return *this;
+    clear_slots();
+
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        destroy_storage();
+        _alloc = another._alloc;
+        _value_alloc = another._value_alloc;
+    } else if (_alloc != another._alloc) {
+        reserve(another._size);
+        for (T& value : another) {
+            emplace_back(std::move(value));
+        }
+        another.clear();
+        return *this;
+    } else {
+        destroy_storage();
+    }
+    steal(another);
+    return *this;
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::~CompactList() {
+    clear_slots();
+    destroy_storage();
+}
+
+// *****
+
+template<typename T, typename Allocator>
+Allocator CompactList<T, Allocator>::get_allocator() const {
+    return _value_alloc;
+}
+
+template<typename T, typename Allocator>
+size_t CompactList<T, Allocator>::size() const {
+    return _size;
+}
+
+template<typename T, typename Allocator>
+size_t CompactList<T, Allocator>::capacity() const {
+    return _capacity - 1;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::reserve(size_t count) {
+    if (count < _capacity) return;
+    if (count >= MAX_CAPACITY) {
+        throw std::length_error("CompactList is too large");
+    }
+    reallocate(count + 1, false);
+}
+
+// *****
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::push_back(const T& value) {
+    emplace(end(), value);
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::push_back(T&& value) {
+    emplace(end(), std::move(value));
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::push_front(const T& value) {
+    emplace(begin(), value);
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::push_front(T&& value) {
+    emplace(begin(), std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+T& CompactList<T, Allocator>::emplace_back(Args&&... args) {
+    return *emplace(end(), std::forward<Args>(args)...);
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+T& CompactList<T, Allocator>::emplace_front(Args&&... args) {
+    return *emplace(begin(), std::forward<Args>(args)...);
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::pop_back() {
+    erase(--end());
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::pop_front() {
+    erase(begin());
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::clear() {
+    clear_slots();
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::defragment() {
+    reallocate(_capacity, true);
+}
+
+// *****
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::begin() const {
+    return iterator(_anchor, _slots[NIL].next);
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::end() const {
+    return iterator(_anchor, NIL);
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::const_iterator CompactList<T, Allocator>::cbegin() const {
+    return const_iterator(_anchor, _slots[NIL].next);
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::const_iterator CompactList<T, Allocator>::cend() const {
+    return const_iterator(_anchor, NIL);
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::reverse_iterator CompactList<T, Allocator>::rbegin() const {
+    return reverse_iterator(end());
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::reverse_iterator CompactList<T, Allocator>::rend() const {
+    return reverse_iterator(begin());
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::const_reverse_iterator
+        CompactList<T, Allocator>::crbegin() const {
+    return const_reverse_iterator(cend());
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::const_reverse_iterator
+        CompactList<T, Allocator>::crend() const {
+    return const_reverse_iterator(cbegin());
+}
+
+// *****
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::insert(
+        common_iterator<isConst> it, const T& value) {
+    return emplace(it, value);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::insert(
+        common_iterator<isConst> it, T&& value) {
+    return emplace(it, std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::insert(
+        common_iterator<isConst> it) {
+    return emplace(it);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::insert(
+        common_iterator<isConst> it, node_type&& node) {
+    if (node.empty()) return end();
+    iterator ret = emplace(it, std::move(*node.stored));
+    node.reset();
+    return ret;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, typename... Args>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::emplace(
+        common_iterator<isConst> it, Args&&... args) {
+    if (_free == NIL && _used == _capacity) {
+        if (_capacity == MAX_CAPACITY) {
+            throw std::length_error("CompactList is too large");
+        }
+        // args may refer to an element of this list, so build the value before the slab moves
+        T value(std::forward<Args>(args)...);
+        reallocate(std::min(MAX_CAPACITY, std::max<size_t>(8, 2 * size_t(_capacity))), false);
+        return emplace(it, std::move(value));
+    }
+
+    uint32_t index = acquire_slot();
+    try {
+        ValueAllocTraits::construct(_value_alloc, _slots[index].value(),
+                std::forward<Args>(args)...);
+    } catch (...) {
+        release_slot(index);
+        throw;
+    }
+    Slot& slot = _slots[index];
+    slot.next = it.index;
+    slot.prev = _slots[it.index].prev;
+    _slots[slot.prev].next = index;
+    _slots[it.index].prev = index;
+    ++_size;
+    return iterator(_anchor, index);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::iterator CompactList<T, Allocator>::erase(
+        common_iterator<isConst> it) {
+    Slot& slot = _slots[it.index];
+    uint32_t next = slot.next;
+    _slots[slot.prev].next = next;
+    _slots[next].prev = slot.prev;
+    ValueAllocTraits::destroy(_value_alloc, slot.value());
+    release_slot(it.index);
+    --_size;
+    return iterator(_anchor, next);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::node_type CompactList<T, Allocator>::extract(
+        common_iterator<isConst> it) {
+    node_type node(std::move(*it), _value_alloc);
+    erase(it);
+    return node;
+}
+
+// *****
+
+template<typename T, typename Allocator>
+template<bool isConst>
+void CompactList<T, Allocator>::splice(common_iterator<isConst> it, CompactList& another) {
+    if (&another == this) return;
+    splice(it, another, another.begin(), another.end());
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, bool isConst1>
+void CompactList<T, Allocator>::splice(common_iterator<isConst> it, CompactList& another,
+        common_iterator<isConst1> element) {
+    splice(it, another, element, std::next(element));
+}
+
+template<typename T, typename Allocator>
+template<bool isConst, bool isConst1>
+void CompactList<T, Allocator>::splice(common_iterator<isConst> it, CompactList& another,
+        common_iterator<isConst1> first, common_iterator<isConst1> last) {
+    if (&another == this) {
+        relink(it.index, first.index, last.index);
+        return;
+    }
+    // slots belong to one slab, so elements from another list are moved rather than relinked
+    reserve(_size + std::distance(first, last));
+    while (first != last) {
+        emplace(it, std::move(*first));
+        first = another.erase(first);
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+void CompactList<T, Allocator>::merge(CompactList& another, Compare comp) {
+    if (&another == this) return;
+    reserve(_size + another._size);
+    uint32_t mine = _slots[NIL].next;
+    for (T& value : another) {
+        while (mine != NIL && !comp(value, *_slots[mine].value())) {
+            mine = _slots[mine].next;
+        }
+        emplace(iterator(_anchor, mine), std::move(value));
+    }
+    another.clear();
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+void CompactList<T, Allocator>::sort(Compare comp) {
+    if (_size < 2) return;
+    uint32_t bins[64] = {};
+    size_t used = 0;
+    for (uint32_t index = _slots[NIL].next; index != NIL; ) {
+        uint32_t carry = index;
+        index = _slots[index].next;
+        _slots[carry].next = NIL;
+        size_t i = 0;
+        for ( ; bins[i] != NIL; ++i) {
+            carry = merge_chains(bins[i], carry, comp);
+            bins[i] = NIL;
+        }
+        bins[i] = carry;
+        used = std::max(used, i + 1);
+    }
+
+    uint32_t sorted = NIL;
+    for (size_t i = 0; i < used; ++i) {
+        if (bins[i] != NIL) {
+            sorted = sorted == NIL ? bins[i] : merge_chains(bins[i], sorted, comp);
+        }
+    }
+
+    uint32_t prev = NIL;
+    for (uint32_t index = sorted; index != NIL; index = _slots[index].next) {
+        _slots[index].prev = prev;
+        _slots[prev].next = index;
+        prev = index;
+    }
+    _slots[prev].next = NIL;
+    _slots[NIL].prev = prev;
+}
+
+// *****
+
+template<typename T, typename Allocator>
+uint32_t CompactList<T, Allocator>::acquire_slot() {
+    if (_free == NIL) {
+        return _used++;
+    }
+    uint32_t index = _free;
+    _free = _slots[index].next;
+    return index;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::release_slot(uint32_t index) {
+    _slots[index].next = _free;
+    _free = index;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::reallocate(size_t capacity, bool in_order) {
+    Slot* slots = AllocTraits::allocate(_alloc, capacity);
+    uint32_t target = 1;
+    uint32_t index = _slots[NIL].next;
+    try {
+        for ( ; index != NIL; index = _slots[index].next, ++target) {
+            ValueAllocTraits::construct(_value_alloc, slots[in_order ? target : index].value(),
+                    std::move_if_noexcept(*_slots[index].value()));
+        }
+    } catch (...) {
+        uint32_t done = target;
+        target = 1;
+        for (index = _slots[NIL].next; target < done; index = _slots[index].next, ++target) {
+            ValueAllocTraits::destroy(_value_alloc, slots[in_order ? target : index].value());
+        }
+        AllocTraits::deallocate(_alloc, slots, capacity);
+        throw;
+    }
+
+    for (index = _slots[NIL].next; index != NIL; index = _slots[index].next) {
+        ValueAllocTraits::destroy(_value_alloc, _slots[index].value());
+    }
+    if (in_order) {
+        for (uint32_t i = 0; i <= _size; ++i) {
+            slots[i].next = i == _size ? NIL : i + 1;
+            slots[i].prev = i == 0 ? static_cast<uint32_t>(_size) : i - 1;
+        }
+        _used = static_cast<uint32_t>(_size) + 1;
+        _free = NIL;
+    } else {
+        for (uint32_t i = 0; i < _used; ++i) {
+            slots[i].next = _slots[i].next;
+            slots[i].prev = _slots[i].prev;
+        }
+    }
+    AllocTraits::deallocate(_alloc, _slots, _capacity);
+    _slots = *_anchor = slots;
+    _capacity = static_cast<uint32_t>(capacity);
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::clear_slots() {
+    for (uint32_t index = _slots[NIL].next; index != NIL; index = _slots[index].next) {
+        ValueAllocTraits::destroy(_value_alloc, _slots[index].value());
+    }
+    _slots[NIL].next = _slots[NIL].prev = NIL;
+    _used = 1;
+    _free = NIL;
+    _size = 0;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::create_storage() {
+    AnchorAlloc anchor_alloc(_alloc);
+    _anchor = AnchorAllocTraits::allocate(anchor_alloc, 1);
+    try {
+        _slots = AllocTraits::allocate(_alloc, 1);
+    } catch (...) {
+        AnchorAllocTraits::deallocate(anchor_alloc, _anchor, 1);
+        throw;
+    }
+    *_anchor = _slots;
+    _slots[NIL].next = _slots[NIL].prev = NIL;
+    _capacity = _used = 1;
+    _free = NIL;
+    _size = 0;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::destroy_storage() {
+    AnchorAlloc anchor_alloc(_alloc);
+    AllocTraits::deallocate(_alloc, _slots, _capacity);
+    AnchorAllocTraits::deallocate(anchor_alloc, _anchor, 1);
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::steal(CompactList& another) {
+    Slot* slots = another._slots;
+    Slot** anchor = another._anchor;
+    uint32_t capacity = another._capacity;
+    uint32_t used = another._used;
+    uint32_t first_free = another._free;
+    size_t size = another._size;
+    another.create_storage();
+
+    _slots = slots;
+    _anchor = anchor;
+    _capacity = capacity;
+    _used = used;
+    _free = first_free;
+    _size = size;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::relink(uint32_t position, uint32_t first, uint32_t last) {
+    if (first == last || position == first || position == last) return;
+    uint32_t tail = _slots[last].prev;
+    _slots[_slots[first].prev].next = last;
+    _slots[last].prev = _slots[first].prev;
+    _slots[first].prev = _slots[position].prev;
+    _slots[tail].next = position;
+    _slots[_slots[position].prev].next = first;
+    _slots[position].prev = tail;
+}
+
+template<typename T, typename Allocator>
+template<typename Compare>
+uint32_t CompactList<T, Allocator>::merge_chains(uint32_t first, uint32_t second,
+        Compare& comp) {
+    uint32_t head = NIL;
+    uint32_t* tail = &head;
+    while (first != NIL && second != NIL) {
+        if (comp(*_slots[second].value(), *_slots[first].value())) {
+            *tail = second;
+            second = _slots[second].next;
+        } else {
+            *tail = first;
+            first = _slots[first].next;
+        }
+        tail = &_slots[*tail].next;
+    }
+    *tail = first != NIL ? first : second;
+    return head;
+}
+
+// *****
+// CompactList::iterator
+
+template<typename T, typename Allocator>
+template<bool isConst>
+CompactList<T, Allocator>::common_iterator<isConst>::common_iterator() {}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+CompactList<T, Allocator>::common_iterator<isConst>::common_iterator(Slot* const* anchor,
+        uint32_t index): anchor(anchor), index(index) {}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+CompactList<T, Allocator>::common_iterator<isConst>::common_iterator(
+        const common_iterator<false>& it): anchor(it.anchor), index(it.index) {}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+bool CompactList<T, Allocator>::common_iterator<isConst>::operator==(common_iterator<isConst> x) {
+    return anchor == x.anchor && index == x.index;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+bool CompactList<T, Allocator>::common_iterator<isConst>::operator!=(common_iterator<isConst> x) {
+    return !operator==(x);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+std::conditional_t<isConst, const T&, T&>
+        CompactList<T, Allocator>::common_iterator<isConst>::operator*() {
+    return *(*anchor)[index].value();
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+std::conditional_t<isConst, const T*, T*>
+        CompactList<T, Allocator>::common_iterator<isConst>::operator->() {
+    return (*anchor)[index].value();
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::template common_iterator<isConst>&
+        CompactList<T, Allocator>::common_iterator<isConst>::operator++() {
+    index = (*anchor)[index].next;
+    return *this;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::template common_iterator<isConst>
+        CompactList<T, Allocator>::common_iterator<isConst>::operator++(int) {
+    common_iterator<isConst> ret = *this;
+    ++*this;
+    return ret;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::template common_iterator<isConst>&
+        CompactList<T, Allocator>::common_iterator<isConst>::operator--() {
+    index = (*anchor)[index].prev;
+    return *this;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename CompactList<T, Allocator>::template common_iterator<isConst>
+        CompactList<T, Allocator>::common_iterator<isConst>::operator--(int) {
+    common_iterator<isConst> ret = *this;
+    --*this;
+    return ret;
+}
+
+// *****
+// CompactList::node_type
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::node_type::node_type() {}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::node_type::node_type(T&& value, const Allocator& alloc):
+        stored(std::move(value)), alloc(alloc) {}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::node_type::node_type(node_type&& another):
+        stored(std::move(another.stored)), alloc(another.alloc) {
+    another.reset();
+}
+
+template<typename T, typename Allocator>
+typename CompactList<T, Allocator>::node_type& CompactList<T, Allocator>::node_type::operator=(
+        node_type&& another) {
+    if (&another == this) return *this;
+    stored = std::move(another.stored);
+    alloc = another.alloc;
+    another.reset();
+    return *this;
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::node_type::~node_type() {}
+
+template<typename T, typename Allocator>
+bool CompactList<T, Allocator>::node_type::empty() const {
+    return !stored.has_value();
+}
+
+template<typename T, typename Allocator>
+CompactList<T, Allocator>::node_type::operator bool() const {
+    return stored.has_value();
+}
+
+template<typename T, typename Allocator>
+T& CompactList<T, Allocator>::node_type::value() const {
+    return *stored;
+}
+
+template<typename T, typename Allocator>
+Allocator CompactList<T, Allocator>::node_type::get_allocator() const {
+    return *alloc;
+}
+
+template<typename T, typename Allocator>
+void CompactList<T, Allocator>::node_type::reset() {
+    stored.reset();
+    alloc.reset();
+}
+
+// *****
+// CompactList::Slot
+
+template<typename T, typename Allocator>
+T* CompactList<T, Allocator>::Slot::value() {
+    return reinterpret_cast<T*>(storage);
+}
+
+// *****
+// CONCURRENT QUEUE
+// *****
+
+template<typename T, typename Allocator>
+ConcurrentQueue<T, Allocator>::ConcurrentQueue(const Allocator& _alloc):
+        _records(nullptr), _record_count(0), _alloc(_alloc), _record_alloc(_alloc),
+        _value_alloc(_alloc) {
+    Node* dummy = allocate_node();
+    _head.store(dummy);
+    _tail.store(dummy);
+}
+
+template<typename T, typename Allocator>
+ConcurrentQueue<T, Allocator>::~ConcurrentQueue() {
+    Node* node = _head.load();
+    deallocate_node(std::exchange(node, node->next.load()));
+    while (node != nullptr) {
+        ValueAllocTraits::destroy(_value_alloc, node->value());
+        deallocate_node(std::exchange(node, node->next.load()));
+    }
+    for (HazardRecord* record = _records.load(); record != nullptr; ) {
+        for (node = record->retired; node != nullptr; ) {
+            deallocate_node(std::exchange(node, node->retired_next));
+        }
+        HazardRecord* next = record->next;
+        RecordAllocTraits::destroy(_record_alloc, record);
+        RecordAllocTraits::deallocate(_record_alloc, record, 1);
+        record = next;
+    }
+}
+
+// *****
+
+template<typename T, typename Allocator>
+Allocator ConcurrentQueue<T, Allocator>::get_allocator() const {
+    return _value_alloc;
+}
+
+template<typename T, typename Allocator>
+bool ConcurrentQueue<T, Allocator>::empty() {
+    HazardRecord* record = acquire_record();
+    bool ret = protect(record->hazards[0], _head)->next.load() == nullptr;
+    release_record(record);
+    return ret;
+}
+
+// *****
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::push_back(const T& value) {
+    emplace_back(value);
+}
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::push_back(T&& value) {
+    emplace_back(std::move(value));
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+void ConcurrentQueue<T, Allocator>::emplace_back(Args&&... args) {
+    Node* node = allocate_node();
+    try {
+        ValueAllocTraits::construct(_value_alloc, node->value(), std::forward<Args>(args)...);
+    } catch (...) {
+        deallocate_node(node);
+        throw;
+    }
+
+    HazardRecord* record = acquire_record();
+    while (true) {
+        Node* tail = protect(record->hazards[0], _tail);
+        Node* next = tail->next.load();
+        if (tail != _tail.load()) continue;
+        if (next != nullptr) {
+            _tail.compare_exchange_weak(tail, next);
+        } else if (tail->next.compare_exchange_weak(next, node)) {
+            _tail.compare_exchange_strong(tail, node);
+            break;
+        }
+    }
+    release_record(record);
+}
+
+template<typename T, typename Allocator>
+std::optional<T> ConcurrentQueue<T, Allocator>::pop_front() {
+    HazardRecord* record = acquire_record();
+    while (true) {
+        Node* head = protect(record->hazards[0], _head);
+        Node* tail = _tail.load();
+        Node* next = head->next.load();
+        record->hazards[1].store(next);
+        if (head != _head.load()) continue;
+        if (next == nullptr) break;
+        if (head == tail) {
+            _tail.compare_exchange_weak(tail, next);
+        } else if (_head.compare_exchange_weak(head, next)) {
+            std::optional<T> ret;
+            try {
+                ret.emplace(std::move(*next->value()));
+            } catch (...) {
+                ValueAllocTraits::destroy(_value_alloc, next->value());
+                retire(record, head);
+                release_record(record);
+                throw;
+            }
+            ValueAllocTraits::destroy(_value_alloc, next->value());
+            retire(record, head);
+            release_record(record);
+            return ret;
+        }
+    }
+    release_record(record);
+    return std::nullopt;
+}
+
+// *****
+
+template<typename T, typename Allocator>
+typename ConcurrentQueue<T, Allocator>::Node* ConcurrentQueue<T, Allocator>::allocate_node() {
+    Node* node = AllocTraits::allocate(_alloc, 1);
+    AllocTraits::construct(_alloc, node);
+    return node;
+}
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::deallocate_node(Node* node) {
+    AllocTraits::destroy(_alloc, node);
+    AllocTraits::deallocate(_alloc, node, 1);
+}
+
+template<typename T, typename Allocator>
+typename ConcurrentQueue<T, Allocator>::HazardRecord* ConcurrentQueue<T, Allocator>::acquire_record() {
+    for (HazardRecord* record = _records.load(); record != nullptr; record = record->next) {
+        bool active = false;
+        if (!record->active.load() && record->active.compare_exchange_strong(active, true)) {
+            return record;
+        }
+    }
+    HazardRecord* record = RecordAllocTraits::allocate(_record_alloc, 1);
+    RecordAllocTraits::construct(_record_alloc, record);
+    record->next = _records.load();
+    while (!_records.compare_exchange_weak(record->next, record)) {}
+    ++_record_count;
+    return record;
+}
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::release_record(HazardRecord* record) {
+    record->hazards[0].store(nullptr);
+    record->hazards[1].store(nullptr);
+    record->active.store(false);
+}
+
+template<typename T, typename Allocator>
+typename ConcurrentQueue<T, Allocator>::Node* ConcurrentQueue<T, Allocator>::protect(
+        std::atomic<Node*>& hazard, const std::atomic<Node*>& source) {
+    Node* node = source.load();
+    while (true) {
+        hazard.store(node);
+        Node* current = source.load();
+        if (current == node) return node;
+        node = current;
+    }
+}
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::retire(HazardRecord* record, Node* node) {
+    node->retired_next = record->retired;
+    record->retired = node;
+    // a scan frees all but at most 2 * _record_count nodes, so the retired list stays bounded
+    if (++record->retired_count >= RETIRED_SCAN_MINIMUM + 4 * _record_count.load()) {
+        scan(record);
+    }
+}
+
+template<typename T, typename Allocator>
+void ConcurrentQueue<T, Allocator>::scan(HazardRecord* record) {
+    Node* kept = nullptr;
+    size_t kept_count = 0;
+    for (Node* node = record->retired; node != nullptr; ) {
+        Node* next = node->retired_next;
+        bool hazardous = false;
+        for (HazardRecord* other = _records.load(); other != nullptr && !hazardous;
+                other = other->next) {
+            hazardous = other->hazards[0].load() == node || other->hazards[1].load() == node;
+        }
+        if (hazardous) {
+            node->retired_next = kept;
+            kept = node;
+            ++kept_count;
+        } else {
+            deallocate_node(node);
+        }
+        node = next;
+    }
+    record->retired = kept;
+    record->retired_count = kept_count;
+}
+
+// *****
+// ConcurrentQueue::HazardRecord
+
+template<typename T, typename Allocator>
+ConcurrentQueue<T, Allocator>::HazardRecord::HazardRecord():
+        hazards{nullptr, nullptr}, active(true), next(nullptr), retired(nullptr), retired_count(0) {}
+
+// *****
+// ConcurrentQueue::Node
+
+template<typename T, typename Allocator>
+ConcurrentQueue<T, Allocator>::Node::Node(): next(nullptr), retired_next(nullptr) {}
+
+template<typename T, typename Allocator>
+T* ConcurrentQueue<T, Allocator>::Node::value() {
+    return reinterpret_cast<T*>(storage);
+}
@@ -1,6 +1,18 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <type_traits>
+#include <stdexcept>
+#include <cstdint>
+#include <atomic>
 
 template<typename T, typename Allocator = std::allocator<T>>
 class List {
@@ -8,40 +20,77 @@ class List {
     explicit List(const Allocator& _alloc = Allocator());
     List(size_t count);
     List(size_t count, const T& value, const Allocator& _alloc = Allocator());
+    template<typename InputIterator,
+            typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    List(InputIterator first, InputIterator last, const Allocator& _alloc = Allocator());
     List(const List& another);
+    List(List&& another) noexcept;
     List& operator=(const List& another);
+    List& operator=(List&& another);
     ~List();
 
     Allocator get_allocator() const;
     size_t size() const;
 
     void push_back(const T& x);
+    void push_back(T&& x);
     void push_front(const T& x);
+    void push_front(T&& x);
+    template<typename... Args>
+    T& emplace_back(Args&&... args);
+    template<typename... Args>
+    T& emplace_front(Args&&... args);
     void pop_back();
     void pop_front();
+    void clear();
 
   private:
-    struct Node {
+    struct NodeBase {
+        NodeBase* next;
+        NodeBase* prev;
+    };
+
+    struct Node : NodeBase {
         T value;
-        Node* next;
-        Node* prev;
 
         Node();
         Node(const T& value);
         Node(const Node& another);
+        template<typename... Args>
+        Node(Args&&... args);
     };
 
     using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
     using AllocTraits = std::allocator_traits<NodeAlloc>;
 
-    Node* _base;
+    template<typename Alloc, typename = void>
+    struct has_bulk_allocation : std::false_type {};
+    template<typename Alloc>
+    struct has_bulk_allocation<Alloc, std::void_t<decltype(std::declval<Alloc&>().allocate_bulk(
+            size_t(), std::declval<typename Alloc::value_type**>(), bool()))>> : std::true_type {};
+
+    inline static const size_t BULK_BATCH_SIZE = 64;
+
+    NodeBase _base;
     NodeAlloc _alloc;
     size_t _size;
 
+    void allocate_nodes(size_t count, Node** nodes, bool contiguous = false);
+    void deallocate_nodes(Node** nodes, size_t count);
+    template<typename Construct>
+    void append_nodes(size_t count, Construct construct);
+    void clear_nodes();
+    void steal(List& another);
+    void transfer(NodeBase* position, NodeBase* first, NodeBase* last, List& another,
+            size_t count);
+    void link(NodeBase* position, NodeBase* node);
+    template<typename Compare>
+    static NodeBase* merge_chains(NodeBase* first, NodeBase* second, Compare& comp);
+
     template<bool isConst>
     struct common_iterator {
       private:
-        Node* adress;
+        NodeBase* adress;
       public:
         using difference_type = std::ptrdiff_t;
         using value_type = std::conditional_t<isConst, const T, T>;
@@ -50,7 +99,7 @@ class List {
         using iterator_category = std::bidirectional_iterator_tag;
 
         common_iterator();
-        common_iterator(Node* x);
+        common_iterator(NodeBase* x);
         common_iterator(const common_iterator<false>& it);
         bool operator==(common_iterator<isConst> x);
         bool operator!=(common_iterator<isConst> x);
@@ -71,6 +120,28 @@ class List {
     typedef std::reverse_iterator<iterator> reverse_iterator;
     typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
 
+    class node_type {
+      public:
+        node_type();
+        node_type(node_type&& another);
+        node_type& operator=(node_type&& another);
+        ~node_type();
+
+        bool empty() const;
+        explicit operator bool() const;
+        T& value() const;
+        Allocator get_allocator() const;
+
+      private:
+        Node* node;
+        std::optional<NodeAlloc> alloc;
+
+        node_type(Node* node, const NodeAlloc& alloc);
+        void reset();
+
+        friend class List<T, Allocator>;
+    };
+
     iterator begin() const;
     iterator end() const;
     const_iterator cbegin() const;
@@ -83,7 +154,471 @@ class List {
     template<bool isConst>
     iterator insert(common_iterator<isConst> it, const T& value);
     template<bool isConst>
+    iterator insert(common_iterator<isConst> it, T&& value);
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, node_type&& node);
+    template<bool isConst, typename... Args>
+    iterator emplace(common_iterator<isConst> it, Args&&... args);
+    template<bool isConst>
     iterator insert(common_iterator<isConst> it);
     template<bool isConst>
     void erase(common_iterator<isConst> it);
+    template<bool isConst>
+    node_type extract(common_iterator<isConst> it);
+
+    template<bool isConst>
+    void splice(common_iterator<isConst> it, List& another);
+    template<bool isConst, bool isConst1>
+    void splice(common_iterator<isConst> it, List& another, common_iterator<isConst1> element);
+    template<bool isConst, bool isConst1>
+    void splice(common_iterator<isConst> it, List& another, common_iterator<isConst1> first,
+            common_iterator<isConst1> last);
+
+    template<typename Compare = std::less<T>>
+    void merge(List& another, Compare comp = Compare());
+    template<typename Compare = std::less<T>>
+    void sort(Compare comp = Compare());
+
+    void defragment();
+};
+
+template<typename T, typename Allocator = std::allocator<T>,
+        size_t blockCapacity = std::max<size_t>(4, 256 / sizeof(T))>
+class UnrolledList {
+  public:
+    explicit UnrolledList(const Allocator& _alloc = Allocator());
+    UnrolledList(const UnrolledList& another);
+    UnrolledList(UnrolledList&& another) noexcept;
+    UnrolledList& operator=(const UnrolledList& another);
+    UnrolledList& operator=(UnrolledList&& another) noexcept(
+            std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value ||
+            std::allocator_traits<Allocator>::is_always_equal::value);
+    ~UnrolledList();
+
+    Allocator get_allocator() const;
+    size_t size() const;
+
+    void push_back(const T& x);
+    void push_back(T&& x);
+    void push_front(const T& x);
+    void push_front(T&& x);
+    template<typename... Args>
+    T& emplace_back(Args&&... args);
+    template<typename... Args>
+    T& emplace_front(Args&&... args);
+    void pop_back();
+    void pop_front();
+    void clear();
+
+  private:
+    struct BlockBase {
+        BlockBase* next;
+        BlockBase* prev;
+        size_t count;
+    };
+
+    struct Block : BlockBase {
+        alignas(T) unsigned char storage[blockCapacity * sizeof(T)];
+
+        static T* values(BlockBase* block);
+    };
+
+    using BlockAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Block>;
+    using AllocTraits = std::allocator_traits<BlockAlloc>;
+    using ValueAllocTraits = std::allocator_traits<Allocator>;
+
+    BlockBase _base;
+    BlockAlloc _alloc;
+    Allocator _value_alloc;
+    size_t _size;
+
+    Block* allocate_block(BlockBase* before);
+    void deallocate_block(BlockBase* block);
+    void relocate(BlockBase* from, size_t from_index, BlockBase* to, size_t to_index, size_t count);
+    void clear_blocks();
+    void steal(UnrolledList& another);
+
+    template<bool isConst>
+    struct common_iterator {
+      private:
+        BlockBase* block;
+        size_t index;
+      public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::conditional_t<isConst, const T, T>;
+        using pointer = std::conditional_t<isConst, const T*, T*>;
+        using reference = std::conditional_t<isConst, const T&, T&>;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        common_iterator();
+        common_iterator(BlockBase* block, size_t index);
+        common_iterator(const common_iterator<false>& it);
+        bool operator==(common_iterator<isConst> x);
+        bool operator!=(common_iterator<isConst> x);
+        reference operator*();
+        pointer operator->();
+        common_iterator<isConst>& operator++();
+        common_iterator<isConst> operator++(int);
+        common_iterator<isConst>& operator--();
+        common_iterator<isConst> operator--(int);
+
+        friend class UnrolledList<T, Allocator, blockCapacity>;
+    };
+  public:
+    typedef common_iterator<false> iterator;
+    typedef common_iterator<true> const_iterator;
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, const T& value);
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, T&& value);
+    template<bool isConst, typename... Args>
+    iterator emplace(common_iterator<isConst> it, Args&&... args);
+    template<bool isConst>
+    iterator erase(common_iterator<isConst> it);
+};
+
+template<typename Tag = void>
+struct IntrusiveListHook {
+    IntrusiveListHook* next = nullptr;
+    IntrusiveListHook* prev = nullptr;
+
+    IntrusiveListHook();
+    IntrusiveListHook(const IntrusiveListHook& another);
+    IntrusiveListHook& operator=(const IntrusiveListHook& another);
+
+    bool is_linked() const;
+};
+
+template<typename T, typename Tag = void>
+class IntrusiveList {
+  public:
+    IntrusiveList();
+    IntrusiveList(const IntrusiveList& another) = delete;
+    IntrusiveList(IntrusiveList&& another);
+    IntrusiveList& operator=(const IntrusiveList& another) = delete;
+    IntrusiveList& operator=(IntrusiveList&& another);
+    ~IntrusiveList();
+
+    size_t size() const;
+
+    void push_back(T& x);
+    void push_front(T& x);
+    void pop_back();
+    void pop_front();
+    void remove(T& x);
+    void clear();
+
+  private:
+    using Hook = IntrusiveListHook<Tag>;
+
+    Hook _base;
+    size_t _size;
+
+    void link(Hook* position, Hook* node);
+    void unlink(Hook* node);
+    void steal(IntrusiveList& another);
+
+    template<bool isConst>
+    struct common_iterator {
+      private:
+        Hook* adress;
+      public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::conditional_t<isConst, const T, T>;
+        using pointer = std::conditional_t<isConst, const T*, T*>;
+        using reference = std::conditional_t<isConst, const T&, T&>;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        common_iterator();
+        common_iterator(Hook* x);
+        common_iterator(const common_iterator<false>& it);
+        bool operator==(common_iterator<isConst> x);
+        bool operator!=(common_iterator<isConst> x);
+        reference operator*();
+        pointer operator->();
+        common_iterator<isConst>& operator++();
+        common_iterator<isConst> operator++(int);
+        common_iterator<isConst>& operator--();
+        common_iterator<isConst> operator--(int);
+
+        friend class IntrusiveList<T, Tag>;
+    };
+  public:
+    typedef common_iterator<false> iterator;
+    typedef common_iterator<true> const_iterator;
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+
+    iterator iterator_to(T& x) const;
+
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, T& x);
+    template<bool isConst>
+    iterator erase(common_iterator<isConst> it);
 };
+
+template<typename T, typename Allocator = std::allocator<T>>
+class CompactList {
+  public:
+    explicit CompactList(const Allocator& _alloc = Allocator());
+    CompactList(size_t count);
+    CompactList(size_t count, const T& value, const Allocator& _alloc = Allocator());
+    template<typename InputIterator,
+            typename = typename std::iterator_traits<InputIterator>::iterator_category>
+    CompactList(InputIterator first, InputIterator last, const Allocator& _alloc = Allocator());
+    CompactList(const CompactList& another);
+    CompactList(CompactList&& another);
+    CompactList& operator=(const CompactList& another);
+    CompactList& operator=(CompactList&& another);
+    ~CompactList();
+
+    Allocator get_allocator() const;
+    size_t size() const;
+    size_t capacity() const;
+    void reserve(size_t count);
+
+    void push_back(const T& x);
+    void push_back(T&& x);
+    void push_front(const T& x);
+    void push_front(T&& x);
+    template<typename... Args>
+    T& emplace_back(Args&&... args);
+    template<typename... Args>
+    T& emplace_front(Args&&... args);
+    void pop_back();
+    void pop_front();
+    void clear();
+
+    void defragment();
+
+  private:
+    struct Slot {
+        uint32_t next;
+        uint32_t prev;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value();
+    };
+
+    using SlotAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using AllocTraits = std::allocator_traits<SlotAlloc>;
+    using AnchorAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot*>;
+    using AnchorAllocTraits = std::allocator_traits<AnchorAlloc>;
+    using ValueAllocTraits = std::allocator_traits<Allocator>;
+
+    inline static const uint32_t NIL = 0;
+    inline static const size_t MAX_CAPACITY = UINT32_MAX;
+
+    Slot* _slots;
+    Slot** _anchor;
+    uint32_t _capacity;
+    uint32_t _used;
+    uint32_t _free;
+    size_t _size;
+    SlotAlloc _alloc;
+    Allocator _value_alloc;
+
+    uint32_t acquire_slot();
+    void release_slot(uint32_t index);
+    void reallocate(size_t capacity, bool in_order);
+    void clear_slots();
+    void create_storage();
+    void destroy_storage();
+    void steal(CompactList& another);
+    void relink(uint32_t position, uint32_t first, uint32_t last);
+    template<typename Compare>
+    uint32_t merge_chains(uint32_t first, uint32_t second, Compare& comp);
+
+    template<bool isConst>
+    struct common_iterator {
+      private:
+        Slot* const* anchor;
+        uint32_t index;
+      public:
+        using difference_type = std::ptrdiff_t;
+        using value_type = std::conditional_t<isConst, const T, T>;
+        using pointer = std::conditional_t<isConst, const T*, T*>;
+        using reference = std::conditional_t<isConst, const T&, T&>;
+        using iterator_category = std::bidirectional_iterator_tag;
+
+        common_iterator();
+        common_iterator(Slot* const* anchor, uint32_t index);
+        common_iterator(const common_iterator<false>& it);
+        bool operator==(common_iterator<isConst> x);
+        bool operator!=(common_iterator<isConst> x);
+        reference operator*();
+        pointer operator->();
+        common_iterator<isConst>& operator++();
+        common_iterator<isConst> operator++(int);
+        common_iterator<isConst>& operator--();
+        common_iterator<isConst> operator--(int);
+
+        friend class CompactList<T, Allocator>;
+    };
+  public:
+    typedef common_iterator<false> iterator;
+    typedef common_iterator<true> const_iterator;
+
+    typedef std::reverse_iterator<iterator> reverse_iterator;
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    class node_type {
+      public:
+        node_type();
+        node_type(node_type&& another);
+        node_type& operator=(node_type&& another);
+        ~node_type();
+
+        bool empty() const;
+        explicit operator bool() const;
+        T& value() const;
+        Allocator get_allocator() const;
+
+      private:
+        mutable std::optional<T> stored;
+        std::optional<Allocator> alloc;
+
+        node_type(T&& value, const Allocator& alloc);
+        void reset();
+
+        friend class CompactList<T, Allocator>;
+    };
+
+    iterator begin() const;
+    iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+    reverse_iterator rbegin() const;
+    reverse_iterator rend() const;
+    const_reverse_iterator crbegin() const;
+    const_reverse_iterator crend() const;
+
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, const T& value);
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, T&& value);
+    template<bool isConst, typename... Args>
+    iterator emplace(common_iterator<isConst> it, Args&&... args);
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it);
+    template<bool isConst>
+    iterator insert(common_iterator<isConst> it, node_type&& node);
+    template<bool isConst>
+    iterator erase(common_iterator<isConst> it);
+    template<bool isConst>
+    node_type extract(common_iterator<isConst> it);
+
+    template<bool isConst>
+    void splice(common_iterator<isConst> it, CompactList& another);
+    template<bool isConst, bool isConst1>
+    void splice(common_iterator<isConst> it, CompactList& another,
+            common_iterator<isConst1> element);
+    template<bool isConst, bool isConst1>
+    void splice(common_iterator<isConst> it, CompactList& another, common_iterator<isConst1> first,
+            common_iterator<isConst1> last);
+
+    template<typename Compare = std::less<T>>
+    void merge(CompactList& another, Compare comp = Compare());
+    template<typename Compare = std::less<T>>
+    void sort(Compare comp = Compare());
+};
+
+template<typename T, typename Allocator = std::allocator<T>>
+class ConcurrentQueue {
+  public:
+    explicit ConcurrentQueue(const Allocator& _alloc = Allocator());
+    ConcurrentQueue(const ConcurrentQueue& another) = delete;
+    ConcurrentQueue& operator=(const ConcurrentQueue& another) = delete;
+    ~ConcurrentQueue();
+
+    Allocator get_allocator() const;
+    bool empty();
+
+    void push_back(const T& x);
+    void push_back(T&& x);
+    template<typename... Args>
+    void emplace_back(Args&&... args);
+    std::optional<T> pop_front();
+
+  private:
+    struct Node {
+        std::atomic<Node*> next;
+        Node* retired_next;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        Node();
+        T* value();
+    };
+
+    struct HazardRecord {
+        std::atomic<Node*> hazards[2];
+        std::atomic<bool> active;
+        HazardRecord* next;
+        Node* retired;
+        size_t retired_count;
+
+        HazardRecord();
+    };
+
+    using NodeAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using AllocTraits = std::allocator_traits<NodeAlloc>;
+    using RecordAlloc = typename std::allocator_traits<Allocator>::template rebind_alloc<HazardRecord>;
+    using RecordAllocTraits = std::allocator_traits<RecordAlloc>;
+    using ValueAllocTraits = std::allocator_traits<Allocator>;
+
+    inline static const size_t CACHE_LINE_SIZE = 64;
+    inline static const size_t RETIRED_SCAN_MINIMUM = 64;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> _head;
+    alignas(CACHE_LINE_SIZE) std::atomic<Node*> _tail;
+    alignas(CACHE_LINE_SIZE) std::atomic<HazardRecord*> _records;
+    std::atomic<size_t> _record_count;
+    NodeAlloc _alloc;
+    RecordAlloc _record_alloc;
+    Allocator _value_alloc;
+
+    Node* allocate_node();
+    void deallocate_node(Node* node);
+    HazardRecord* acquire_record();
+    void release_record(HazardRecord* record);
+    Node* protect(std::atomic<Node*>& hazard, const std::atomic<Node*>& source);
+    void retire(HazardRecord* record, Node* node);
+    void scan(HazardRecord* record);
+};
+
+namespace pmr {
+    template<typename T>
+    using List = ::List<T, std::pmr::polymorphic_allocator<T>>;
+
+    template<typename T>
+    using UnrolledList = ::UnrolledList<T, std::pmr::polymorphic_allocator<T>>;
+
+    template<typename T>
+    using CompactList = ::CompactList<T, std::pmr::polymorphic_allocator<T>>;
+
+    template<typename T>
+    using ConcurrentQueue = ::ConcurrentQueue<T, std::pmr::polymorphic_allocator<T>>;
+}
@@ -0,0 +1,559 @@
+#include "list.cpp"
+#include "fastallocator.cpp"
+
+#include <list>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <cstdlib>
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "list_test: " << what << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+template<typename Container, typename T>
+bool same(const Container& container, const std::list<T>& expected) {
+    if (container.size() != expected.size()) return false;
+    auto it = expected.begin();
+    for (const T& value : container) {
+        if (it == expected.end() || *it != value) return false;
+        ++it;
+    }
+    return it == expected.end();
+}
+
+std::atomic<long> live_allocations(0);
+std::atomic<long> peak_allocations(0);
+
+template<typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U>&) {}
+
+    T* allocate(size_t count) {
+        long live = ++live_allocations;
+        long peak = peak_allocations.load();
+        while (live > peak && !peak_allocations.compare_exchange_weak(peak, live)) {}
+        return std::allocator<T>().allocate(count);
+    }
+
+    void deallocate(T* pointer, size_t count) {
+        --live_allocations;
+        std::allocator<T>().deallocate(pointer, count);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U>&) const { return true; }
+    template<typename U>
+    bool operator!=(const CountingAllocator<U>&) const { return false; }
+};
+
+template<template<typename...> class Container>
+void test_against_std(const char* name) {
+    std::mt19937 random(41);
+    Container<int> list;
+    std::list<int> expected;
+    for (int step = 0; step < 20000; ++step) {
+        int value = random() % 1000;
+        switch (random() % 6) {
+            case 0:
+                list.push_back(value);
+                expected.push_back(value);
+                break;
+            case 1:
+                list.push_front(value);
+                expected.push_front(value);
+                break;
+            case 2:
+                if (!expected.empty()) {
+                    list.pop_back();
+                    expected.pop_back();
+                }
+                break;
+            case 3:
+                if (!expected.empty()) {
+                    list.pop_front();
+                    expected.pop_front();
+                }
+                break;
+            case 4: {
+                size_t position = random() % (expected.size() + 1);
+                list.insert(std::next(list.begin(), position), value);
+                expected.insert(std::next(expected.begin(), position), value);
+                break;
+            }
+            case 5:
+                if (!expected.empty()) {
+                    size_t position = random() % expected.size();
+                    list.erase(std::next(list.begin(), position));
+                    expected.erase(std::next(expected.begin(), position));
+                }
+                break;
+        }
+    }
+    if (!same(list, expected) ||
+            !std::equal(list.rbegin(), list.rend(), expected.rbegin(), expected.rend())) {
+        std::cerr << name << ": ";
+        check(false, "contents after random operations");
+    }
+}
+
+template<typename T>
+using SmallUnrolledList = UnrolledList<T, std::allocator<T>, 4>;
+
+void test_unrolled_list() {
+    SmallUnrolledList<std::string> list;
+    std::list<std::string> expected;
+    for (int i = 0; i < 100; ++i) {
+        list.push_back(std::to_string(i));
+        expected.push_back(std::to_string(i));
+    }
+    SmallUnrolledList<std::string> copy = list;
+    SmallUnrolledList<std::string> moved(std::move(list));
+    check(list.size() == 0 && list.begin() == list.end(), "moved-from UnrolledList is empty");
+    check(std::equal(copy.begin(), copy.end(), expected.begin(), expected.end()) &&
+            std::equal(moved.begin(), moved.end(), expected.begin(), expected.end()),
+            "UnrolledList copy and move");
+
+    for (SmallUnrolledList<std::string>::iterator it = moved.begin(); it != moved.end(); ) {
+        it = it->size() == 1 ? moved.erase(it) : std::next(it);
+    }
+    expected.remove_if([](const std::string& value) { return value.size() == 1; });
+    check(std::equal(moved.begin(), moved.end(), expected.begin(), expected.end()),
+            "UnrolledList erase while iterating");
+    copy = moved;
+    moved.clear();
+    check(moved.size() == 0 && copy.size() == expected.size(), "UnrolledList assignment");
+
+    static_assert(std::is_nothrow_move_constructible_v<SmallUnrolledList<std::string>> &&
+            std::is_nothrow_move_assignable_v<SmallUnrolledList<std::string>>,
+            "UnrolledList moves are noexcept");
+    long live = live_allocations;
+    UnrolledList<int, CountingAllocator<int>, 4> counted;
+    UnrolledList<int, CountingAllocator<int>, 4> empty_move(std::move(counted));
+    check(live_allocations == live, "an empty UnrolledList allocates nothing");
+    for (int i = 0; i < 10; ++i) {
+        counted.push_back(i);
+    }
+    int* first = &*counted.begin();
+    long filled = live_allocations;
+    empty_move = std::move(counted);
+    check(live_allocations == filled && &*empty_move.begin() == first,
+            "UnrolledList move assignment keeps the blocks");
+    check(counted.size() == 0 && counted.begin() == counted.end(), "UnrolledList moved from");
+}
+
+struct ByAge {};
+
+struct Item : IntrusiveListHook<>, IntrusiveListHook<ByAge> {
+    int value = 0;
+};
+
+void test_intrusive_list() {
+    std::vector<Item> items(200);
+    for (int i = 0; i < 200; ++i) {
+        items[i].value = i;
+    }
+    IntrusiveList<Item> list;
+    IntrusiveList<Item, ByAge> by_age;
+    std::list<int> expected;
+    std::list<int> expected_by_age;
+    std::mt19937 random(44);
+    for (int step = 0; step < 20000; ++step) {
+        Item& item = items[random() % items.size()];
+        IntrusiveListHook<>& hook = item;
+        if (!hook.is_linked()) {
+            if (random() % 2 == 0) {
+                list.push_back(item);
+                expected.push_back(item.value);
+            } else {
+                list.push_front(item);
+                expected.push_front(item.value);
+            }
+        } else if (random() % 2 == 0) {
+            list.erase(list.iterator_to(item));
+            expected.remove(item.value);
+        } else {
+            list.remove(item);
+            expected.remove(item.value);
+        }
+        if (!static_cast<IntrusiveListHook<ByAge>&>(item).is_linked()) {
+            by_age.push_back(item);
+            expected_by_age.push_back(item.value);
+        }
+    }
+    auto values = [](const auto& container) {
+        std::list<int> ret;
+        for (const Item& item : container) {
+            ret.push_back(item.value);
+        }
+        return ret;
+    };
+    check(values(list) == expected && list.size() == expected.size(),
+            "IntrusiveList after random operations");
+    check(values(by_age) == expected_by_age, "one item linked into two lists by tag");
+
+    Item copy = items[0];
+    check(!static_cast<IntrusiveListHook<ByAge>&>(copy).is_linked(),
+            "copying an item does not link it");
+
+    IntrusiveList<Item> moved(std::move(list));
+    check(list.size() == 0 && list.begin() == list.end(), "moved-from IntrusiveList is empty");
+    check(values(moved) == expected, "IntrusiveList move");
+    moved.clear();
+    by_age.clear();
+    for (const Item& item : items) {
+        check(!static_cast<const IntrusiveListHook<>&>(item).is_linked(), "clear unlinks items");
+    }
+}
+
+void test_list_move() {
+    static_assert(std::is_nothrow_move_constructible_v<List<int>>);
+    List<int> list;
+    for (int i = 0; i < 100; ++i) {
+        list.push_back(i);
+    }
+    List<int>::iterator first = list.begin();
+    List<int>::iterator last = std::prev(list.end());
+    List<int> moved(std::move(list));
+    check(list.size() == 0 && list.begin() == list.end(), "moved-from List is empty");
+    check(moved.size() == 100 && *first == 0 && *last == 99, "iterators survive a move");
+    check(moved.begin() == first && std::next(last) == moved.end(), "moved List owns the nodes");
+    list.push_back(7);
+    check(list.size() == 1 && *list.begin() == 7, "moved-from List is reusable");
+
+    List<int> empty;
+    List<int> moved_empty(std::move(empty));
+    check(moved_empty.begin() == moved_empty.end(), "move of an empty List");
+
+    list = std::move(moved);
+    check(list.size() == 100 && list.begin() == first, "move assignment keeps the nodes");
+    List<int> copy = list;
+    copy = list;
+    check(copy.size() == 100 && *std::prev(copy.end()) == 99, "copy assignment");
+}
+
+struct ThrowOnDefault {
+    int value;
+
+    ThrowOnDefault() { throw std::runtime_error("default"); }
+    ThrowOnDefault(int value): value(value) {}
+};
+
+void test_default_insert() {
+    List<int> list;
+    list.push_back(1);
+    List<int>::iterator it = list.insert(list.begin());
+    check(list.size() == 2 && it == list.begin() && *std::next(it) == 1,
+            "insert of a default value");
+
+    long live = live_allocations;
+    List<ThrowOnDefault, CountingAllocator<ThrowOnDefault>> throwing;
+    throwing.push_back(ThrowOnDefault(1));
+    bool thrown = false;
+    try {
+        throwing.insert(throwing.end());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    check(thrown && throwing.size() == 1 && live_allocations == live + 1,
+            "a throwing default insert frees its node");
+}
+
+template<template<typename...> class Container>
+void test_splice_merge_sort(const char* name) {
+    std::mt19937 random(42);
+    for (int round = 0; round < 200; ++round) {
+        Container<int> first;
+        Container<int> second;
+        std::list<int> expected_first;
+        std::list<int> expected_second;
+        for (int i = random() % 50; i > 0; --i) {
+            int value = random() % 100;
+            first.push_back(value);
+            expected_first.push_back(value);
+        }
+        for (int i = random() % 50; i > 0; --i) {
+            int value = random() % 100;
+            second.push_back(value);
+            expected_second.push_back(value);
+        }
+
+        size_t position = random() % (expected_first.size() + 1);
+        size_t begin = random() % (expected_second.size() + 1);
+        size_t end = begin + random() % (expected_second.size() - begin + 1);
+        first.splice(std::next(first.begin(), position), second, std::next(second.begin(), begin),
+                std::next(second.begin(), end));
+        expected_first.splice(std::next(expected_first.begin(), position), expected_second,
+                std::next(expected_second.begin(), begin), std::next(expected_second.begin(), end));
+
+        if (!expected_first.empty()) {
+            size_t from = random() % expected_first.size();
+            size_t to = random() % (expected_first.size() + 1);
+            first.splice(std::next(first.begin(), to), first, std::next(first.begin(), from));
+            expected_first.splice(std::next(expected_first.begin(), to), expected_first,
+                    std::next(expected_first.begin(), from));
+        }
+
+        first.sort();
+        second.sort(std::greater<int>());
+        expected_first.sort();
+        expected_second.sort(std::greater<int>());
+        if (!same(first, expected_first) || !same(second, expected_second)) {
+            std::cerr << name << ": ";
+            check(false, "splice and sort");
+        }
+
+        second.sort();
+        expected_second.sort();
+        first.merge(second);
+        expected_first.merge(expected_second);
+        if (!same(first, expected_first) || second.size() != 0) {
+            std::cerr << name << ": ";
+            check(false, "merge");
+        }
+
+        first.splice(first.begin(), second);
+        first.splice(first.end(), first);
+        if (!same(first, expected_first)) {
+            std::cerr << name << ": ";
+            check(false, "splice of an empty or the same list");
+        }
+    }
+
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < 1000; ++i) {
+        pairs.emplace_back(random() % 10, i);
+    }
+    auto by_key = [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first < b.first;
+    };
+    Container<std::pair<int, int>> stable(pairs.begin(), pairs.end());
+    stable.sort(by_key);
+    std::stable_sort(pairs.begin(), pairs.end(), by_key);
+    if (!std::equal(stable.begin(), stable.end(), pairs.begin(), pairs.end())) {
+        std::cerr << name << ": ";
+        check(false, "sort is stable");
+    }
+}
+
+void test_compact_list() {
+    CompactList<int> list;
+    list.push_back(1);
+    CompactList<int>::iterator first = list.begin();
+    for (int i = 2; i <= 100; ++i) {
+        list.push_back(i);
+    }
+    check(*first == 1 && list.capacity() >= 100, "iterators survive growth");
+
+    CompactList<int>::iterator last = std::prev(list.end());
+    CompactList<int> moved(std::move(list));
+    check(list.size() == 0 && list.begin() == list.end(), "moved-from CompactList is empty");
+    check(*first == 1 && *last == 100 && moved.begin() == first, "iterators survive a move");
+    check(std::next(last) == moved.end(), "end iterator follows the move");
+
+    std::list<int> expected(moved.begin(), moved.end());
+    CompactList<int>::node_type node = moved.extract(std::next(moved.begin(), 10));
+    expected.erase(std::next(expected.begin(), 10));
+    check(!node.empty() && node.value() == 11 && same(moved, expected), "extract");
+    node.value() = -11;
+    CompactList<int>::iterator inserted = moved.insert(moved.begin(), std::move(node));
+    expected.push_front(-11);
+    check(node.empty() && *inserted == -11 && same(moved, expected), "insert of a node handle");
+    check(moved.insert(moved.end(), CompactList<int>::node_type()) == moved.end(),
+            "insert of an empty node handle");
+
+    for (CompactList<int>::iterator it = moved.begin(); it != moved.end(); ) {
+        it = *it % 3 == 0 ? moved.erase(it) : std::next(it);
+    }
+    expected.remove_if([](int value) { return value % 3 == 0; });
+    moved.defragment();
+    check(same(moved, expected), "defragment keeps the order");
+}
+
+template<typename Container>
+size_t scattered_steps(const Container& container) {
+    std::vector<const char*> addresses;
+    for (const int& value : container) {
+        addresses.push_back(reinterpret_cast<const char*>(&value));
+    }
+    size_t steps = 0;
+    for (size_t i = 2; i < addresses.size(); ++i) {
+        steps += addresses[i] - addresses[i - 1] != addresses[1] - addresses[0];
+    }
+    return steps;
+}
+
+void test_list_node_handles() {
+    List<std::string> list;
+    std::list<std::string> expected;
+    for (int i = 0; i < 10; ++i) {
+        list.push_back(std::to_string(i));
+        expected.push_back(std::to_string(i));
+    }
+    List<std::string>::iterator third = std::next(list.begin(), 3);
+    std::string* address = &*third;
+    List<std::string>::node_type node = list.extract(third);
+    expected.erase(std::next(expected.begin(), 3));
+    check(!node.empty() && node.value() == "3" && same(list, expected), "List extract");
+
+    node.value() = "three";
+    List<std::string> other;
+    List<std::string>::iterator inserted = other.insert(other.end(), std::move(node));
+    check(node.empty() && &*inserted == address && *inserted == "three",
+            "a node moves between lists without copying its value");
+    check(list.insert(list.begin(), List<std::string>::node_type()) == list.end(),
+            "insert of an empty node handle");
+
+    std::pmr::unsynchronized_pool_resource first_resource;
+    std::pmr::unsynchronized_pool_resource second_resource;
+    pmr::List<std::string> first(&first_resource);
+    pmr::List<std::string> second(&second_resource);
+    first.push_back("moved across resources");
+    second.insert(second.end(), first.extract(first.begin()));
+    check(first.size() == 0 && second.size() == 1 && *second.begin() == "moved across resources",
+            "node handle insert with an unequal allocator");
+
+    long live = live_allocations;
+    {
+        List<int, CountingAllocator<int>> counted(5, 1);
+        List<int, CountingAllocator<int>>::node_type dropped = counted.extract(counted.begin());
+        check(counted.size() == 4, "extract shrinks the list");
+    }
+    check(live_allocations == live, "a dropped node handle frees its node");
+}
+
+void test_splice_unequal_allocators() {
+    std::pmr::unsynchronized_pool_resource first_resource;
+    std::pmr::unsynchronized_pool_resource second_resource;
+    pmr::List<int> first(&first_resource);
+    pmr::List<int> second(&second_resource);
+    std::list<int> expected_first;
+    std::list<int> expected_second;
+    for (int i = 0; i < 20; ++i) {
+        first.push_back(2 * i);
+        second.push_back(2 * i + 1);
+        expected_first.push_back(2 * i);
+        expected_second.push_back(2 * i + 1);
+    }
+    first.splice(std::next(first.begin(), 5), second, std::next(second.begin(), 3),
+            std::next(second.begin(), 8));
+    expected_first.splice(std::next(expected_first.begin(), 5), expected_second,
+            std::next(expected_second.begin(), 3), std::next(expected_second.begin(), 8));
+    check(same(first, expected_first) && same(second, expected_second),
+            "splice between unequal allocators");
+    first.sort();
+    first.merge(second);
+    expected_first.sort();
+    expected_first.merge(expected_second);
+    check(same(first, expected_first) && second.size() == 0, "merge between unequal allocators");
+}
+
+void test_bulk_construction() {
+    std::list<int> expected(192, 7);
+    List<int, FastAllocator<int>> filled(192, 7);
+    check(same(filled, expected), "count constructor");
+    // full batches skip the thread cache and are carved from fresh pool space
+    check(scattered_steps(filled) <= 2, "bulk-constructed nodes are contiguous");
+
+    std::iota(expected.begin(), expected.end(), 0);
+    List<int, FastAllocator<int>> copied(expected.begin(), expected.end());
+    List<int, FastAllocator<int>> copy = copied;
+    check(same(copied, expected) && same(copy, expected), "range and copy constructors");
+    check(scattered_steps(copy) <= 2, "copied nodes are contiguous");
+}
+
+void test_defragment() {
+    List<int, FastAllocator<int>> list;
+    std::list<int> expected;
+    {
+        List<int, FastAllocator<int>> other;
+        for (int i = 0; i < 100; ++i) {
+            list.push_back(i);
+            other.push_back(i);
+            expected.push_back(i);
+        }
+    }
+    List<int, FastAllocator<int>>::iterator it = list.begin();
+    for (int i = 0; i < 20; ++i) {
+        List<int, FastAllocator<int>>::iterator next = std::next(it, 2);
+        list.erase(std::next(it));
+        expected.erase(std::next(expected.begin(), i + 1));
+        it = next;
+    }
+
+    list.defragment();
+    check(same(list, expected), "defragment keeps the order");
+    // a batch may straddle a segment boundary, so allow a couple of jumps
+    check(scattered_steps(list) <= 2, "defragment lays out every batch contiguously");
+
+    List<int> plain(expected.begin(), expected.end());
+    plain.defragment();
+    check(same(plain, expected), "defragment without bulk allocation");
+}
+
+void test_concurrent_queue() {
+    const int THREADS = 4;
+    const long PER_THREAD = 200000;
+    std::atomic<long> popped_sum(0);
+    std::atomic<long> popped_count(0);
+    {
+        ConcurrentQueue<long, CountingAllocator<long>> queue;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&queue, &popped_sum, &popped_count, t] {
+                long sum = 0;
+                long count = 0;
+                for (long i = 0; i < PER_THREAD; ++i) {
+                    queue.push_back(t * PER_THREAD + i);
+                    if (std::optional<long> value = queue.pop_front()) {
+                        sum += *value;
+                        ++count;
+                    }
+                }
+                popped_sum += sum;
+                popped_count += count;
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        while (std::optional<long> value = queue.pop_front()) {
+            popped_sum += *value;
+            ++popped_count;
+        }
+        check(queue.empty(), "queue is drained");
+    }
+    long total = THREADS * PER_THREAD;
+    check(popped_count == total, "every pushed value is popped once");
+    check(popped_sum == total * (total - 1) / 2, "popped values match pushed values");
+    // at most THREADS values are queued at once; the rest of the peak is retired nodes
+    check(peak_allocations < 4096, "retired nodes are reclaimed under sustained load");
+    check(live_allocations == 0, "queue frees everything on destruction");
+}
+
+int main() {
+    test_against_std<List>("List");
+    test_against_std<SmallUnrolledList>("UnrolledList");
+    test_unrolled_list();
+    test_intrusive_list();
+    test_list_move();
+    test_default_insert();
+    test_splice_merge_sort<List>("List");
+    test_splice_unequal_allocators();
+    test_list_node_handles();
+    test_bulk_construction();
+    test_defragment();
+    test_against_std<CompactList>("CompactList");
+    test_splice_merge_sort<CompactList>("CompactList");
+    test_compact_list();
+    test_concurrent_queue();
+    std::cout << "list_test: ok" << std::endl;
+    return 0;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "lru_cache.h"
+
+// *****
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+LruCache<Key, Value, Hash, Equal, Alloc>::LruCache(size_t max_entries, const Alloc& alloc):
+        _entries(alloc), _evicted(alloc), _index(IndexAlloc(alloc)), _max_entries(max_entries),
+        _max_bytes(UNLIMITED), _bytes(0), _hits(0), _misses(0), _evictions(0) {}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+LruCache<Key, Value, Hash, Equal, Alloc>::LruCache(size_t max_bytes, Sizer sizer,
+        const Alloc& alloc):
+        _entries(alloc), _evicted(alloc), _index(IndexAlloc(alloc)), _sizer(std::move(sizer)),
+        _max_entries(UNLIMITED), _max_bytes(max_bytes), _bytes(0), _hits(0), _misses(0),
+        _evictions(0) {}
+
+// *****
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::size() const {
+    return _entries.size();
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::bytes() const {
+    return _bytes;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::max_entries() const {
+    return _max_entries;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::max_bytes() const {
+    return _max_bytes;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::hits() const {
+    return _hits;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::misses() const {
+    return _misses;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::evictions() const {
+    return _evictions;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void LruCache<Key, Value, Hash, Equal, Alloc>::reset_stats() {
+    _hits = _misses = _evictions = 0;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void LruCache<Key, Value, Hash, Equal, Alloc>::set_eviction_callback(EvictionCallback callback) {
+    _on_evict = std::move(callback);
+}
+
+// *****
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+Value* LruCache<Key, Value, Hash, Equal, Alloc>::get(const Key& key) {
+    typename Index::Iterator found = _index.find(key);
+    if (found == _index.end()) {
+        ++_misses;
+        return nullptr;
+    }
+    ++_hits;
+    _entries.splice(_entries.begin(), _entries, found->second);
+    return &found->second->second;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+Value* LruCache<Key, Value, Hash, Equal, Alloc>::peek(const Key& key) {
+    typename Index::Iterator found = _index.find(key);
+    return found == _index.end() ? nullptr : &found->second->second;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+template<typename V>
+Value* LruCache<Key, Value, Hash, Equal, Alloc>::put(const Key& key, V&& value) {
+    typename Index::Iterator found = _index.find(key);
+    ListIterator entry;
+    if (found != _index.end()) {
+        entry = found->second;
+        size_t old_bytes = entry_bytes(entry->first, entry->second);
+        entry->second = std::forward<V>(value);
+        _bytes -= old_bytes;
+        _entries.splice(_entries.begin(), _entries, entry);
+    } else {
+        _entries.emplace_front(key, std::forward<V>(value));
+        entry = _entries.begin();
+        try {
+            _index.emplace(key, entry);
+        } catch (...) {
+            _entries.pop_front();
+            throw;
+        }
+    }
+    _bytes += entry_bytes(entry->first, entry->second);
+    evict();
+    return _entries.size() == 0 ? nullptr : &entry->second;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+bool LruCache<Key, Value, Hash, Equal, Alloc>::erase(const Key& key) {
+    typename Index::Iterator found = _index.find(key);
+    if (found == _index.end()) return false;
+    ListIterator entry = found->second;
+    _bytes -= entry_bytes(entry->first, entry->second);
+    _index.erase(found);
+    _entries.erase(entry);
+    return true;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void LruCache<Key, Value, Hash, Equal, Alloc>::clear() {
+    _index.erase(_index.begin(), _index.end());
+    _entries.clear();
+    _bytes = 0;
+}
+
+// *****
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename LruCache<Key, Value, Hash, Equal, Alloc>::const_iterator
+        LruCache<Key, Value, Hash, Equal, Alloc>::begin() const {
+    return _entries.cbegin();
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename LruCache<Key, Value, Hash, Equal, Alloc>::const_iterator
+        LruCache<Key, Value, Hash, Equal, Alloc>::end() const {
+    return _entries.cend();
+}
+
+// *****
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+size_t LruCache<Key, Value, Hash, Equal, Alloc>::entry_bytes(const Key& key,
+        const Value& value) const {
+    return _sizer ? _sizer(key, value) : 0;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void LruCache<Key, Value, Hash, Equal, Alloc>::evict() {
+    while (_entries.size() > _max_entries || _bytes > _max_bytes) {
+        ListIterator last = --_entries.end();
+        _bytes -= entry_bytes(last->first, last->second);
+        _index.erase(_index.find(last->first));
+        _evicted.splice(_evicted.end(), _entries, last);
+        ++_evictions;
+    }
+    if (_evicted.size() == 0) return;
+    if (_on_evict) {
+        try {
+            _on_evict(_evicted);
+        } catch (...) {
+            _evicted.clear();
+            throw;
+        }
+    }
+    _evicted.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "list.cpp"
+#include "unordered_map.cpp"
+
+#include <functional>
+#include <limits>
+
+template<typename Key, typename Value, typename Hash = std::hash<Key>,
+        typename Equal = std::equal_to<Key>, typename Alloc =
+        std::allocator<std::pair<const Key, Value>>>
+class LruCache {
+  public:
+    using Entry = std::pair<const Key, Value>;
+    using EntryList = List<Entry, Alloc>;
+    using Sizer = std::function<size_t(const Key&, const Value&)>;
+    using EvictionCallback = std::function<void(EntryList& evicted)>;
+
+    typedef typename EntryList::const_iterator const_iterator;
+
+    explicit LruCache(size_t max_entries, const Alloc& alloc = Alloc());
+    LruCache(size_t max_bytes, Sizer sizer, const Alloc& alloc = Alloc());
+    LruCache(const LruCache& another) = delete;
+    LruCache& operator=(const LruCache& another) = delete;
+
+    size_t size() const;
+    size_t bytes() const;
+    size_t max_entries() const;
+    size_t max_bytes() const;
+
+    size_t hits() const;
+    size_t misses() const;
+    size_t evictions() const;
+    void reset_stats();
+
+    void set_eviction_callback(EvictionCallback callback);
+
+    Value* get(const Key& key);
+    Value* peek(const Key& key);
+    template<typename V>
+    Value* put(const Key& key, V&& value);
+    bool erase(const Key& key);
+    void clear();
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+  private:
+    using ListIterator = typename EntryList::iterator;
+    using IndexAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<
+            std::pair<const Key, ListIterator>>;
+    using Index = UnorderedMap<Key, ListIterator, Hash, Equal, IndexAlloc>;
+
+    inline static const size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+    EntryList _entries;
+    EntryList _evicted;
+    Index _index;
+    Sizer _sizer;
+    EvictionCallback _on_evict;
+    size_t _max_entries;
+    size_t _max_bytes;
+    size_t _bytes;
+    size_t _hits;
+    size_t _misses;
+    size_t _evictions;
+
+    size_t entry_bytes(const Key& key, const Value& value) const;
+    void evict();
+};
@@ -0,0 +1,127 @@
+#include "lru_cache.cpp"
+
+#include <list>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "lru_cache_test: " << what << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+// most recently used first
+using Model = std::list<std::pair<int, int>>;
+
+Model::iterator model_find(Model& model, int key) {
+    return std::find_if(model.begin(), model.end(),
+            [key](const std::pair<int, int>& entry) { return entry.first == key; });
+}
+
+bool same(const LruCache<int, int>& cache, const Model& model) {
+    if (cache.size() != model.size()) return false;
+    auto it = model.begin();
+    for (const std::pair<const int, int>& entry : cache) {
+        if (it == model.end() || entry.first != it->first || entry.second != it->second) {
+            return false;
+        }
+        ++it;
+    }
+    return it == model.end();
+}
+
+void test_against_model() {
+    const size_t CAPACITY = 50;
+    LruCache<int, int> cache(CAPACITY);
+    Model model;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    std::mt19937 random(50);
+    for (int step = 0; step < 50000; ++step) {
+        int key = random() % 120;
+        int value = random() % 1000;
+        Model::iterator found = model_find(model, key);
+        switch (random() % 4) {
+            case 0: {
+                int* got = cache.get(key);
+                check((got == nullptr) == (found == model.end()), "get finds the same keys");
+                if (found != model.end()) {
+                    check(*got == found->second, "get returns the stored value");
+                    model.splice(model.begin(), model, found);
+                    ++hits;
+                } else {
+                    ++misses;
+                }
+                break;
+            }
+            case 1: {
+                int* got = cache.peek(key);
+                check((got == nullptr) == (found == model.end()), "peek finds the same keys");
+                break;
+            }
+            case 2:
+                cache.put(key, value);
+                if (found != model.end()) {
+                    model.erase(found);
+                }
+                model.emplace_front(key, value);
+                if (model.size() > CAPACITY) {
+                    model.pop_back();
+                    ++evictions;
+                }
+                break;
+            case 3:
+                check(cache.erase(key) == (found != model.end()), "erase result");
+                if (found != model.end()) {
+                    model.erase(found);
+                }
+                break;
+        }
+    }
+    check(same(cache, model), "recency order matches the model");
+    check(cache.hits() == hits && cache.misses() == misses && cache.evictions() == evictions,
+            "hit, miss and eviction counters");
+    cache.reset_stats();
+    check(cache.hits() == 0 && cache.misses() == 0 && cache.evictions() == 0, "reset_stats");
+    cache.clear();
+    check(cache.size() == 0 && cache.begin() == cache.end() && cache.get(1) == nullptr, "clear");
+}
+
+void test_byte_budget() {
+    LruCache<int, std::string> cache(100, [](const int&, const std::string& value) {
+        return value.size();
+    });
+    std::vector<int> evicted;
+    cache.set_eviction_callback([&evicted](LruCache<int, std::string>::EntryList& entries) {
+        for (const auto& entry : entries) {
+            evicted.push_back(entry.first);
+        }
+    });
+    for (int i = 0; i < 10; ++i) {
+        cache.put(i, std::string(20, 'a' + i));
+        check(cache.bytes() <= cache.max_bytes(), "byte budget holds");
+    }
+    check(cache.size() == 5 && cache.bytes() == 100, "budget fits five entries");
+    check(evicted == std::vector<int>({0, 1, 2, 3, 4}), "entries are evicted oldest first");
+
+    evicted.clear();
+    cache.get(5);
+    cache.put(10, std::string(30, 'z'));
+    check(evicted == std::vector<int>({6, 7}), "get protects an entry from eviction");
+    check(cache.peek(5) != nullptr && cache.bytes() == 90, "bytes follow the stored values");
+
+    cache.put(5, std::string(5, 'y'));
+    check(cache.bytes() == 75, "overwrite updates the byte count");
+    check(cache.put(11, std::string(200, 'x')) == nullptr, "an entry over budget is not kept");
+    check(cache.peek(11) == nullptr && cache.size() == 0, "an oversized put evicts everything");
+}
+
+int main() {
+    test_against_model();
+    test_byte_budget();
+    std::cout << "lru_cache_test: ok" << std::endl;
+    return 0;
+}
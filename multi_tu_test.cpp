@@ -0,0 +1,30 @@
+#include "fastallocator.cpp"
+#include "lru_cache.cpp"
+
+#include <vector>
+#include <cstdlib>
+
+size_t use_allocators_in_other_unit();
+
+int main() {
+    std::vector<long, FastAllocator<long>> shared(100, 1);
+    std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+    std::vector<long, ArenaAllocator<long>> arena_vector(100, 1, ArenaAllocator<long>(arena));
+    FastMemoryResource resource;
+    std::pmr::vector<long> pmr_vector(100, 1, &resource);
+    LruCache<int, long> cache(100);
+    for (int i = 0; i < 100; ++i) {
+        cache.put(i, 1);
+    }
+
+    size_t sum = use_allocators_in_other_unit();
+    for (size_t i = 0; i < 100; ++i) {
+        sum += shared[i] + arena_vector[i] + pmr_vector[i] + *cache.peek(i);
+    }
+    if (sum != 2500) {
+        std::cerr << "multi_tu_test: unexpected sum " << sum << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "multi_tu_test: ok" << std::endl;
+    return 0;
+}
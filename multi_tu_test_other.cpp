@@ -0,0 +1,34 @@
+#include "fastallocator.cpp"
+#include "lru_cache.cpp"
+
+#include <vector>
+
+size_t use_allocators_in_other_unit() {
+    std::vector<int, FastAllocator<int>> shared(100, 1);
+
+    std::shared_ptr<PrivatePools> pools = std::make_shared<PrivatePools>();
+    FastAllocator<int> own_alloc(pools);
+    std::vector<int, FastAllocator<int>> own(own_alloc);
+    own.assign(100, 2);
+
+    FastMemoryResource resource;
+    std::pmr::vector<int> pmr_vector(100, 3, &resource);
+
+    std::shared_ptr<Arena> arena = std::make_shared<Arena>();
+    std::vector<int, ArenaAllocator<int>> arena_vector(100, 4, ArenaAllocator<int>(arena));
+
+    List<int> list(100, 5);
+    UnorderedMap<int, int> map;
+    for (int i = 0; i < 100; ++i) {
+        map.emplace(i, 6);
+    }
+
+    size_t sum = 0;
+    for (int value : list) {
+        sum += value;
+    }
+    for (size_t i = 0; i < 100; ++i) {
+        sum += shared[i] + own[i] + pmr_vector[i] + arena_vector[i] + map[i];
+    }
+    return sum;
+}
@@ -1,3 +1,5 @@
+#pragma once
+
 #include "unordered_map.h"
 
 template<typename T, typename Allocator = std::allocator<T>>
@@ -37,11 +39,32 @@ class _List {
     using AllocTraits = std::allocator_traits<NodeAlloc>;
     using BaseAllocTraits = std::allocator_traits<Allocator>;
 
+    template<typename Alloc, typename = void>
+    struct has_bulk_allocation : std::false_type {};
+    template<typename Alloc>
+    struct has_bulk_allocation<Alloc, std::void_t<decltype(std::declval<Alloc&>().allocate_bulk(
+            size_t(), std::declval<typename Alloc::value_type**>(), bool()))>> : std::true_type {};
+
+    inline static const size_t BULK_BATCH_SIZE = 64;
+
     Node* base;
     NodeAlloc alloc;
     Allocator base_alloc;
     size_t _size;
 
+    void allocate_nodes(size_t count, Node** nodes, bool contiguous = false);
+    void deallocate_nodes(Node** nodes, size_t count);
+    template<typename Construct>
+    void append_nodes(size_t count, Construct construct);
+    void clear_nodes();
+
+    template<typename... Args>
+    Node* create_node(Args&&... args);
+    void destroy_node(Node* node);
+
+    template<typename, typename, typename, typename, typename>
+    friend class UnorderedMap;
+
     template<bool isConst>
     struct common_iterator {
       private:
@@ -95,6 +118,14 @@ class _List {
     iterator insert(common_iterator<isConst> it, Args&&... args);
     template<bool isConst>
     void erase(common_iterator<isConst> it);
+
+    void defragment();
+
+  private:
+    template<bool isConst>
+    Node* extract_node(common_iterator<isConst> it);
+    template<bool isConst>
+    iterator insert_node(common_iterator<isConst> it, Node* node);
 };
 
 // *****
@@ -127,24 +158,22 @@ _List<T, Allocator>::_List(size_t count, const T& value, const Allocator& alloc)
 }
 
 template<typename T, typename Allocator>
-_List<T, Allocator>::_List(const _List& another): _size(0) {
-    alloc = AllocTraits::select_on_container_copy_construction(another.alloc);
-    base_alloc = AllocTraits::select_on_container_copy_construction(another.base_alloc);
-
+_List<T, Allocator>::_List(const _List& another):
+        alloc(AllocTraits::select_on_container_copy_construction(another.alloc)),
+        base_alloc(BaseAllocTraits::select_on_container_copy_construction(another.base_alloc)),
+        _size(0) {
     base = AllocTraits::allocate(alloc, 1);
     base->next = base->prev = base;
     iterator it = another.begin();
-    while (it != another.end()) {
-        push_back(*it);
+    append_nodes(another._size, [this, &it](Node* node) {
+        BaseAllocTraits::construct(base_alloc, &node->value, *it);
         ++it;
-    }
+    });
 }
 
 template<typename T, typename Allocator>
-_List<T, Allocator>::_List(_List&& another): _size(another._size) {
-    alloc = another.alloc;
-    base_alloc = another.base_alloc;
-
+_List<T, Allocator>::_List(_List&& another): alloc(another.alloc), base_alloc(another.base_alloc),
+        _size(another._size) {
     base = another.base;
     another.base = AllocTraits::allocate(another.alloc, 1);
     another.base->next = another.base->prev = another.base;
@@ -154,36 +183,42 @@ _List<T, Allocator>::_List(_List&& another): _size(another._size) {
 template<typename T, typename Allocator>
 _List<T, Allocator>& _List<T, Allocator>::operator=(const _List& another) {
     if (another.base == base) return *this;
-    while (_size != 0) {
-        erase(begin());
-    }
+    clear_nodes();
     AllocTraits::deallocate(alloc, base, 1);
 
-    if (AllocTraits::propagate_on_container_copy_assignment::value) {
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
         alloc = another.alloc;
+        base_alloc = another.base_alloc;
     }
 
     base = AllocTraits::allocate(alloc, 1);
     base->next = base->prev = base;
     iterator it = another.begin();
-    while (it != another.end()) {
-        push_back(*it);
+    append_nodes(another._size, [this, &it](Node* node) {
+        BaseAllocTraits::construct(base_alloc, &node->value, *it);
         ++it;
-    }
+    });
     return *this;
 }
 
 template<typename T, typename Allocator>
 _List<T, Allocator>& _List<T, Allocator>::operator=(_List&& another) {
     if (another.base == base) return *this;
-    while (_size != 0) {
-        erase(begin());
-    }
+    clear_nodes();
     AllocTraits::deallocate(alloc, base, 1);
 
-
-    alloc = another.alloc;
-    base_alloc = another.base_alloc;
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        alloc = another.alloc;
+        base_alloc = another.base_alloc;
+    } else if (alloc != another.alloc) {
+        base = AllocTraits::allocate(alloc, 1);
+        base->next = base->prev = base;
+        while (another._size != 0) {
+            insert(end(), std::move(*another.begin()));
+            another.erase(another.begin());
+        }
+        return *this;
+    }
 
     base = another.base;
     another.base = AllocTraits::allocate(alloc, 1);
@@ -196,9 +231,7 @@ _List<T, Allocator>& _List<T, Allocator>::operator=(_List&& another) {
 
 template<typename T, typename Allocator>
 _List<T, Allocator>::~_List() {
-    while (_size != 0) {
-        erase(begin());
-    }
+    clear_nodes();
     AllocTraits::deallocate(alloc, base, 1);
 }
 
@@ -329,15 +362,7 @@ void _List<T, Allocator>::insert(common_iterator<isConst> it,
 template<typename T, typename Allocator>
 template<bool isConst, typename... Args>
 typename _List<T, Allocator>::iterator _List<T, Allocator>::insert(common_iterator<isConst> it, Args&&... args) {
-    Node* node = AllocTraits::allocate(alloc, 1);
-    BaseAllocTraits::construct(base_alloc, &node->value, std::forward<Args>(args)...);
-    node->prev = node->next = node;
-    node->prev = it.adress->prev;
-    node->next = it.adress;
-    it.adress->prev = node;
-    node->prev->next = node;
-    ++_size;
-    return iterator(node);
+    return insert_node(it, create_node(std::forward<Args>(args)...));
 }
 
 template<typename T, typename Allocator>
@@ -350,6 +375,149 @@ void _List<T, Allocator>::erase(common_iterator<isConst> it) {
     --_size;
 }
 
+template<typename T, typename Allocator>
+void _List<T, Allocator>::defragment() {
+    Node* batch[BULK_BATCH_SIZE];
+    Node* old[BULK_BATCH_SIZE];
+    Node* node = base->next;
+    for (size_t left = _size; left > 0; ) {
+        size_t taken = std::min(left, BULK_BATCH_SIZE);
+        allocate_nodes(taken, batch, true);
+        size_t i = 0;
+        try {
+            for ( ; i < taken; ++i, node = node->next) {
+                BaseAllocTraits::construct(base_alloc, &batch[i]->value,
+                        std::move_if_noexcept(node->value));
+                old[i] = node;
+            }
+        } catch (...) {
+            for (size_t j = 0; j < i; ++j) {
+                AllocTraits::destroy(alloc, batch[j]);
+            }
+            deallocate_nodes(batch, taken);
+            throw;
+        }
+        for (i = 0; i < taken; ++i) {
+            batch[i]->prev = old[i]->prev;
+            batch[i]->next = old[i]->next;
+            batch[i]->prev->next = batch[i];
+            batch[i]->next->prev = batch[i];
+            AllocTraits::destroy(alloc, old[i]);
+        }
+        deallocate_nodes(old, taken);
+        left -= taken;
+    }
+}
+
+// *****
+
+template<typename T, typename Allocator>
+void _List<T, Allocator>::allocate_nodes(size_t count, Node** nodes, bool contiguous) {
+    if constexpr (has_bulk_allocation<NodeAlloc>::value) {
+        alloc.allocate_bulk(count, nodes, contiguous);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            nodes[i] = AllocTraits::allocate(alloc, 1);
+        }
+    }
+}
+
+template<typename T, typename Allocator>
+void _List<T, Allocator>::deallocate_nodes(Node** nodes, size_t count) {
+    if constexpr (has_bulk_allocation<NodeAlloc>::value) {
+        alloc.deallocate_bulk(nodes, count);
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            AllocTraits::deallocate(alloc, nodes[i], 1);
+        }
+    }
+}
+
+template<typename T, typename Allocator>
+template<typename Construct>
+void _List<T, Allocator>::append_nodes(size_t count, Construct construct) {
+    Node* batch[BULK_BATCH_SIZE];
+    while (count > 0) {
+        size_t taken = std::min(count, BULK_BATCH_SIZE);
+        allocate_nodes(taken, batch, taken == BULK_BATCH_SIZE);
+        for (size_t i = 0; i < taken; ++i) {
+            try {
+                construct(batch[i]);
+            } catch (...) {
+                deallocate_nodes(batch + i, taken - i);
+                throw;
+            }
+            batch[i]->prev = base->prev;
+            batch[i]->next = base;
+            base->prev->next = batch[i];
+            base->prev = batch[i];
+            ++_size;
+        }
+        count -= taken;
+    }
+}
+
+template<typename T, typename Allocator>
+void _List<T, Allocator>::clear_nodes() {
+    Node* batch[BULK_BATCH_SIZE];
+    size_t count = 0;
+    for (Node* node = base->next; node != base; ) {
+        Node* next = node->next;
+        AllocTraits::destroy(alloc, node);
+        batch[count++] = node;
+        if (count == BULK_BATCH_SIZE) {
+            deallocate_nodes(batch, count);
+            count = 0;
+        }
+        node = next;
+    }
+    if (count != 0) {
+        deallocate_nodes(batch, count);
+    }
+    base->next = base->prev = base;
+    _size = 0;
+}
+
+template<typename T, typename Allocator>
+template<typename... Args>
+typename _List<T, Allocator>::Node* _List<T, Allocator>::create_node(Args&&... args) {
+    Node* node = AllocTraits::allocate(alloc, 1);
+    try {
+        BaseAllocTraits::construct(base_alloc, &node->value, std::forward<Args>(args)...);
+    } catch (...) {
+        AllocTraits::deallocate(alloc, node, 1);
+        throw;
+    }
+    return node;
+}
+
+template<typename T, typename Allocator>
+void _List<T, Allocator>::destroy_node(Node* node) {
+    AllocTraits::destroy(alloc, node);
+    AllocTraits::deallocate(alloc, node, 1);
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename _List<T, Allocator>::Node* _List<T, Allocator>::extract_node(common_iterator<isConst> it) {
+    it.adress->next->prev = it.adress->prev;
+    it.adress->prev->next = it.adress->next;
+    --_size;
+    return it.adress;
+}
+
+template<typename T, typename Allocator>
+template<bool isConst>
+typename _List<T, Allocator>::iterator _List<T, Allocator>::insert_node(common_iterator<isConst> it,
+        Node* node) {
+    node->prev = it.adress->prev;
+    node->next = it.adress;
+    it.adress->prev = node;
+    node->prev->next = node;
+    ++_size;
+    return iterator(node);
+}
+
 // *****
 // _List::iterator
 
@@ -446,10 +614,13 @@ _List<T, Allocator>::Node::Node(Args&&... args):
 // *****
 
 template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
-UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(): alloc(BucketAlloc()),
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(): UnorderedMap(Alloc()) {}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(const Alloc& alloc): alloc(alloc),
         bucket_count(START_BUCKET_COUNT), _size(0),
-        _max_load_factor(STANDART_MAX_LOAD_FACTOR), items(ListType()),
-        pool(AllocTraits::allocate(alloc, bucket_count)) {
+        _max_load_factor(STANDART_MAX_LOAD_FACTOR), items(alloc),
+        pool(AllocTraits::allocate(this->alloc, bucket_count)) {
     for (size_t i = 0; i < bucket_count; ++i) {
         pool[i] = items.end();
     }
@@ -457,19 +628,12 @@ UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(): alloc(BucketAlloc(
 
 template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
 UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(const UnorderedMap& another):
-        bucket_count(another.bucket_count), _size(0),
-        _max_load_factor(another._max_load_factor), items(ListType()) {
-
-    alloc = AllocTraits::select_on_container_copy_construction(another.alloc);
+        alloc(AllocTraits::select_on_container_copy_construction(another.alloc)),
+        bucket_count(another.bucket_count), _size(another._size),
+        _max_load_factor(another._max_load_factor), items(Alloc(alloc)) {
+    items = another.items;
     pool = AllocTraits::allocate(alloc, bucket_count);
-
-    for (size_t i = 0; i < bucket_count; ++i) {
-        pool[i] = items.end();
-    }
-
-    for (auto it = another.items.begin(); it != another.items.end(); ++it) {
-        insert(*it);
-    }
+    rebuild_buckets();
 }
 
 template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
@@ -480,10 +644,9 @@ UnorderedMap<Key, Value, Hash, Equal, Alloc>::UnorderedMap(UnorderedMap&& anothe
         pool(another.pool) {
 
     another._max_load_factor = STANDART_MAX_LOAD_FACTOR;
-    another.items = ListType();
     another.bucket_count = START_BUCKET_COUNT;
     another._size = 0;
-    another.pool = AllocTraits::allocate(alloc, another.bucket_count);
+    another.pool = AllocTraits::allocate(another.alloc, another.bucket_count);
     for (size_t i = 0; i < another.bucket_count; ++i) {
         another.pool[i] = another.items.end();
     }
@@ -493,24 +656,19 @@ template<typename Key, typename Value, typename Hash, typename Equal, typename A
 UnorderedMap<Key, Value, Hash, Equal, Alloc>&
         UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(const UnorderedMap& another) {
 
+    if (&another == this) return *this;
     AllocTraits::deallocate(alloc, pool, bucket_count);
 
-    if (AllocTraits::propagate_on_container_copy_assignment::value) {
+    if constexpr (AllocTraits::propagate_on_container_copy_assignment::value) {
         alloc = another.alloc;
     }
+    items = another.items;
 
     bucket_count = another.bucket_count;
+    _size = another._size;
     _max_load_factor = another._max_load_factor;
     pool = AllocTraits::allocate(alloc, bucket_count);
-
-    for (size_t i = 0; i < bucket_count; ++i) {
-        pool[i] = items.end();
-    }
-
-    _size = 0;
-    for (auto it = another.items.begin(); it != another.items.end(); ++it) {
-        insert(*it);
-    }
+    rebuild_buckets();
     return *this;
 }
 
@@ -518,9 +676,42 @@ template<typename Key, typename Value, typename Hash, typename Equal, typename A
 UnorderedMap<Key, Value, Hash, Equal, Alloc>&
         UnorderedMap<Key, Value, Hash, Equal, Alloc>::operator=(UnorderedMap&& another) {
 
+    if (&another == this) return *this;
+    if constexpr (!AllocTraits::propagate_on_container_move_assignment::value) {
+        if (alloc != another.alloc) {
+            // nodes cannot change hands, so the elements move into nodes from our allocator
+            items.clear_nodes();
+            AllocTraits::deallocate(alloc, pool, bucket_count);
+            bucket_count = another.bucket_count;
+            _size = 0;
+            _max_load_factor = another._max_load_factor;
+            pool = AllocTraits::allocate(alloc, bucket_count);
+            try {
+                for (typename ListType::iterator it = another.items.begin();
+                        it != another.items.end(); ++it) {
+                    items.insert_node(items.end(), items.create_node(std::move_if_noexcept(*it)));
+                }
+            } catch (...) {
+                items.clear_nodes();
+                rebuild_buckets();
+                throw;
+            }
+            _size = another._size;
+            rebuild_buckets();
+
+            another.items.clear_nodes();
+            another._size = 0;
+            for (size_t i = 0; i < another.bucket_count; ++i) {
+                another.pool[i] = another.items.end();
+            }
+            return *this;
+        }
+    }
     AllocTraits::deallocate(alloc, pool, bucket_count);
 
-    alloc = another.alloc;
+    if constexpr (AllocTraits::propagate_on_container_move_assignment::value) {
+        alloc = another.alloc;
+    }
     bucket_count = another.bucket_count;
     _size = another._size,
     _max_load_factor = another._max_load_factor;
@@ -528,10 +719,9 @@ UnorderedMap<Key, Value, Hash, Equal, Alloc>&
     pool = another.pool;
 
     another._max_load_factor = STANDART_MAX_LOAD_FACTOR;
-    another.items = ListType();
     another.bucket_count = START_BUCKET_COUNT;
     another._size = 0;
-    another.pool = AllocTraits::allocate(alloc, another.bucket_count);
+    another.pool = AllocTraits::allocate(another.alloc, another.bucket_count);
     for (size_t i = 0; i < another.bucket_count; ++i) {
         another.pool[i] = another.items.end();
     }
@@ -630,30 +820,33 @@ template<typename Key, typename Value, typename Hash, typename Equal, typename A
 template<typename... Args>
 std::pair<typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator, bool>
         UnorderedMap<Key, Value, Hash, Equal, Alloc>::emplace(Args&&... args) {
-    ListType elem;
-    elem.insert(elem.begin(), std::forward<Args>(args)...);
-    NodeType& x = *elem.begin();
-    Iterator it = find(x.first);
-    Iterator ret = end();
-    bool inserted = false;
-    if (it == end()) {
-        if (1.0 * (_size + 1) / bucket_count > _max_load_factor) {
-            rehash(2 * bucket_count);
-        }
-        size_t index = Hash{}(x.first) % bucket_count;
-        typename ListType::iterator lit = pool[index];
-        if (lit != items.end()) {
-            items.insert(lit, elem.begin(), elem.end(), elem);
-            pool[index] = --lit;
-        } else {
-            items.insert(items.end(), elem.begin(), elem.end(), elem);
-            pool[index] = --items.end();
+    typename ListType::Node* node = items.create_node(std::forward<Args>(args)...);
+    Iterator it = find(node->value.first);
+    if (it != end()) {
+        items.destroy_node(node);
+        return {it, false};
+    }
+    return {link_node(node), true};
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert_return_type
+        UnorderedMap<Key, Value, Hash, Equal, Alloc>::insert(node_type&& node) {
+    if (node.empty()) return {end(), false, node_type()};
+    Iterator it = find(node.key());
+    if (it != end()) return {it, false, std::move(node)};
+    if constexpr (!ListType::AllocTraits::is_always_equal::value) {
+        if (items.alloc != *node.alloc) {
+            typename ListType::Node* own = items.create_node(std::move(node.node->value));
+            node.reset();
+            return {link_node(own), true, node_type()};
         }
-        ++_size;
-        inserted = true;
-        ret = pool[index];
     }
-    return {ret, inserted};
+
+    typename ListType::Node* adress = node.node;
+    node.node = nullptr;
+    node.alloc.reset();
+    return {link_node(adress), true, node_type()};
 }
 
 
@@ -661,6 +854,10 @@ template<typename Key, typename Value, typename Hash, typename Equal, typename A
 template<typename InputIterator>
 void UnorderedMap<Key, Value, Hash, Equal, Alloc>::
         insert(InputIterator begin, InputIterator end) {
+    using Category = typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+        reserve(_size + std::distance(begin, end));
+    }
     for (InputIterator it = begin; it != end; ++it) {
         insert(*it);
     }
@@ -670,13 +867,7 @@ template<typename Key, typename Value, typename Hash, typename Equal, typename A
 template<bool isConst>
 typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
         UnorderedMap<Key, Value, Hash, Equal, Alloc>::erase(common_iterator<isConst> it) {
-    size_t index = Hash{}(it->first) % bucket_count;
-    if (Equal{}(pool[index]->first, it->first)) {
-        ++pool[index];
-        if (pool[index] != items.end() && (Hash{}(pool[index]->first) % bucket_count != index)) {
-            pool[index] = items.end();
-        }
-    }
+    unlink_bucket(it.list_node);
     Iterator ret = Iterator(it.list_node);
     ++ret;
     items.erase(it.list_node);
@@ -698,6 +889,41 @@ typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
     return end;
 }
 
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+template<bool isConst>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type
+        UnorderedMap<Key, Value, Hash, Equal, Alloc>::extract(common_iterator<isConst> it) {
+    unlink_bucket(it.list_node);
+    --_size;
+    return node_type(items.extract_node(it.list_node), items.alloc);
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type
+        UnorderedMap<Key, Value, Hash, Equal, Alloc>::extract(const Key& key) {
+    Iterator it = find(key);
+    if (it == end()) return node_type();
+    return extract(it);
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::merge(UnorderedMap& source) {
+    if (&source == this) return;
+    for (typename ListType::iterator it = source.items.begin(); it != source.items.end(); ) {
+        typename ListType::iterator next = it;
+        ++next;
+        if (find(it->first) == end()) {
+            insert(source.extract(Iterator(it)));
+        }
+        it = next;
+    }
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::merge(UnorderedMap&& source) {
+    merge(source);
+}
+
 template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
 typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
         UnorderedMap<Key, Value, Hash, Equal, Alloc>::find(const Key& key) {
@@ -720,6 +946,17 @@ void UnorderedMap<Key, Value, Hash, Equal, Alloc>::reserve(size_t n) {
     rehash(std::ceil(n / max_load_factor()));
 }
 
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::defragment() {
+    try {
+        items.defragment();
+    } catch (...) {
+        rebuild_buckets();
+        throw;
+    }
+    rebuild_buckets();
+}
+
 template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
 size_t UnorderedMap<Key, Value, Hash, Equal, Alloc>::max_size() const {
     return MAX_SIZE;
@@ -745,6 +982,80 @@ void UnorderedMap<Key, Value, Hash, Equal, Alloc>::max_load_factor(float x) {
     }
 }
 
+// *****
+// UnorderedMap::node_type
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::node_type(): node(nullptr) {}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::node_type(typename ListType::Node* node,
+        const typename ListType::NodeAlloc& alloc): node(node), alloc(alloc) {}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::node_type(node_type&& another): node(another.node),
+        alloc(another.alloc) {
+    another.node = nullptr;
+    another.alloc.reset();
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type&
+        UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::operator=(node_type&& another) {
+    if (&another == this) return *this;
+    reset();
+    node = another.node;
+    alloc = another.alloc;
+    another.node = nullptr;
+    another.alloc.reset();
+    return *this;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::~node_type() {
+    reset();
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+bool UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::empty() const {
+    return node == nullptr;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::operator bool() const {
+    return node != nullptr;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+Key& UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::key() {
+    // the node is out of every bucket, so the key may change before it is inserted again
+    return const_cast<Key&>(node->value.first);
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+const Key& UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::key() const {
+    return node->value.first;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+Value& UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::mapped() const {
+    return node->value.second;
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+Alloc UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::get_allocator() const {
+    return Alloc(*alloc);
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::node_type::reset() {
+    if (node == nullptr) return;
+    ListType::AllocTraits::destroy(*alloc, node);
+    ListType::AllocTraits::deallocate(*alloc, node, 1);
+    node = nullptr;
+    alloc.reset();
+}
+
 // *****
 // UnorderedMap::Iterator
 
@@ -819,13 +1130,13 @@ void UnorderedMap<Key, Value, Hash, Equal, Alloc>::rehash(size_t min_bucket_coun
         }
         if (prime) break;
     }
-    if (min_bucket_count < bucket_count) return;
+    if (min_bucket_count <= bucket_count) return;
 
     AllocTraits::deallocate(alloc, pool, bucket_count);
     bucket_count = min_bucket_count;
     pool = AllocTraits::allocate(alloc, bucket_count);
     ListType old_items = std::move(items);
-    items = ListType();
+    items = ListType(old_items.get_allocator());
     for (size_t i = 0; i < bucket_count; ++i) {
         pool[i] = items.end();
     }
@@ -846,3 +1157,39 @@ void UnorderedMap<Key, Value, Hash, Equal, Alloc>::rehash(size_t min_bucket_coun
         }
     }
 }
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::rebuild_buckets() {
+    for (size_t i = 0; i < bucket_count; ++i) {
+        pool[i] = items.end();
+    }
+    for (typename ListType::iterator it = items.begin(); it != items.end(); ++it) {
+        size_t index = Hash{}(it->first) % bucket_count;
+        if (pool[index] == items.end()) {
+            pool[index] = it;
+        }
+    }
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+typename UnorderedMap<Key, Value, Hash, Equal, Alloc>::Iterator
+        UnorderedMap<Key, Value, Hash, Equal, Alloc>::link_node(typename ListType::Node* node) {
+    if (1.0 * (_size + 1) / bucket_count > _max_load_factor) {
+        rehash(2 * bucket_count);
+    }
+    size_t index = Hash{}(node->value.first) % bucket_count;
+    pool[index] = items.insert_node(pool[index], node);
+    ++_size;
+    return Iterator(pool[index]);
+}
+
+template<typename Key, typename Value, typename Hash, typename Equal, typename Alloc>
+void UnorderedMap<Key, Value, Hash, Equal, Alloc>::unlink_bucket(typename ListType::iterator it) {
+    size_t index = Hash{}(it->first) % bucket_count;
+    if (Equal{}(pool[index]->first, it->first)) {
+        ++pool[index];
+        if (pool[index] != items.end() && (Hash{}(pool[index]->first) % bucket_count != index)) {
+            pool[index] = items.end();
+        }
+    }
+}
@@ -1,6 +1,13 @@
+#pragma once
+
 #include <iostream>
 #include <vector>
 #include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <type_traits>
 #include <stdexcept>
 #include <cmath>
 
@@ -49,7 +56,38 @@ class UnorderedMap {
     using Iterator = common_iterator<false>;
     using ConstIterator = common_iterator<true>;
 
+    class node_type {
+      public:
+        node_type();
+        node_type(node_type&& another);
+        node_type& operator=(node_type&& another);
+        ~node_type();
+
+        bool empty() const;
+        explicit operator bool() const;
+        Key& key();
+        const Key& key() const;
+        Value& mapped() const;
+        Alloc get_allocator() const;
+
+      private:
+        typename ListType::Node* node;
+        std::optional<typename ListType::NodeAlloc> alloc;
+
+        node_type(typename ListType::Node* node, const typename ListType::NodeAlloc& alloc);
+        void reset();
+
+        friend class UnorderedMap<Key, Value, Hash, Equal, Alloc>;
+    };
+
+    struct insert_return_type {
+        Iterator position;
+        bool inserted;
+        node_type node;
+    };
+
     UnorderedMap();
+    explicit UnorderedMap(const Alloc& alloc);
     UnorderedMap(const UnorderedMap& another);
     UnorderedMap(UnorderedMap&& another);
     UnorderedMap<Key, Value, Hash, Equal, Alloc>& operator=(const UnorderedMap& another);
@@ -73,6 +111,7 @@ class UnorderedMap {
     std::pair<Iterator, bool> insert(P&& x);
     template<typename InputIterator>
     void insert(InputIterator begin, InputIterator end);
+    insert_return_type insert(node_type&& node);
     template<typename... Args>
     std::pair<Iterator, bool> emplace(Args&&... args);
 
@@ -81,9 +120,16 @@ class UnorderedMap {
     template<bool isConst>
     Iterator erase(common_iterator<isConst> begin, common_iterator<isConst> end);
 
+    template<bool isConst>
+    node_type extract(common_iterator<isConst> it);
+    node_type extract(const Key& key);
+    void merge(UnorderedMap& source);
+    void merge(UnorderedMap&& source);
+
     Iterator find(const Key& key);
 
     void reserve(size_t n);
+    void defragment();
     size_t max_size() const;
     float load_factor() const;
     float max_load_factor() const;
@@ -102,4 +148,14 @@ class UnorderedMap {
     inline static const size_t MAX_SIZE = UINT32_MAX;
 
     void rehash(size_t min_bucket_count);
+    void rebuild_buckets();
+    Iterator link_node(typename ListType::Node* node);
+    void unlink_bucket(typename ListType::iterator it);
 };
+
+namespace pmr {
+    template<typename Key, typename Value, typename Hash = std::hash<Key>,
+            typename Equal = std::equal_to<Key>>
+    using UnorderedMap = ::UnorderedMap<Key, Value, Hash, Equal,
+            std::pmr::polymorphic_allocator<std::pair<const Key, Value>>>;
+}
@@ -0,0 +1,203 @@
+#include "unordered_map.cpp"
+#include "fastallocator.cpp"
+
+#include <unordered_map>
+#include <random>
+#include <string>
+#include <memory>
+#include <cstdlib>
+
+void check(bool condition, const char* what) {
+    if (!condition) {
+        std::cerr << "unordered_map_test: " << what << std::endl;
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+template<typename Map>
+bool same(Map& map, const std::unordered_map<int, std::string>& expected) {
+    if (map.size() != expected.size()) return false;
+    size_t count = 0;
+    for (auto& item : map) {
+        auto it = expected.find(item.first);
+        if (it == expected.end() || it->second != item.second) return false;
+        ++count;
+    }
+    return count == expected.size();
+}
+
+void test_against_std() {
+    std::mt19937 random(45);
+    UnorderedMap<int, std::string> map;
+    std::unordered_map<int, std::string> expected;
+    for (int step = 0; step < 20000; ++step) {
+        int key = random() % 500;
+        std::string value = std::to_string(random() % 1000);
+        switch (random() % 5) {
+            case 0:
+                check(map.insert({key, value}).second == expected.insert({key, value}).second,
+                        "insert result");
+                break;
+            case 1:
+                map[key] = value;
+                expected[key] = value;
+                break;
+            case 2: {
+                auto it = map.find(key);
+                check((it == map.end()) == (expected.count(key) == 0), "find");
+                if (it != map.end()) {
+                    map.erase(it);
+                    expected.erase(key);
+                }
+                break;
+            }
+            case 3:
+                map.emplace(key, value);
+                expected.emplace(key, value);
+                break;
+            case 4:
+                if (step % 1000 == 0) {
+                    map.defragment();
+                }
+                break;
+        }
+    }
+    check(same(map, expected), "contents after random operations");
+}
+
+void test_node_handles() {
+    UnorderedMap<int, std::string> map;
+    for (int i = 0; i < 10; ++i) {
+        map.emplace(i, std::to_string(i));
+    }
+    auto node = map.extract(3);
+    check(!node.empty() && node.key() == 3 && node.mapped() == "3", "extract by key");
+    check(map.size() == 9 && map.find(3) == map.end(), "extracted key is gone");
+    check(map.extract(3).empty(), "extract of a missing key");
+
+    node.mapped() = "three";
+    auto inserted = map.insert(std::move(node));
+    check(inserted.inserted && node.empty() && inserted.position->second == "three",
+            "insert of an extracted node");
+
+    auto again = map.extract(map.find(3));
+    map.emplace(3, "other");
+    auto rejected = map.insert(std::move(again));
+    check(!rejected.inserted && rejected.node.mapped() == "three", "insert over an existing key");
+    check(rejected.position->second == "other", "existing value is kept");
+
+    UnorderedMap<int, std::string> other;
+    other.insert(map.extract(5));
+    check(other.size() == 1 && other.find(5)->second == "5", "move a node between maps");
+}
+
+void test_node_rekey() {
+    UnorderedMap<int, std::string> map;
+    for (int i = 0; i < 100; ++i) {
+        map.emplace(i, std::to_string(i));
+    }
+    auto node = map.extract(7);
+    const std::string* value = &node.mapped();
+    node.key() = 1007;
+    auto inserted = map.insert(std::move(node));
+    check(inserted.inserted && inserted.position->first == 1007, "insert under the new key");
+    check(&inserted.position->second == value, "re-keyed node is reused without allocating");
+    check(map.find(7) == map.end() && map.find(1007)->second == "7", "lookup by the new key");
+
+    auto clash = map.extract(8);
+    clash.key() = 9;
+    auto rejected = map.insert(std::move(clash));
+    check(!rejected.inserted && rejected.node.key() == 9 && map.size() == 99,
+            "re-keyed node clashing with an existing key");
+}
+
+void test_node_handles_unequal_allocators() {
+    std::pmr::unsynchronized_pool_resource first_resource;
+    std::pmr::unsynchronized_pool_resource second_resource;
+    pmr::UnorderedMap<int, std::string> first(&first_resource);
+    pmr::UnorderedMap<int, std::string> second(&second_resource);
+    first.emplace(1, "first");
+    second.emplace(1, "second");
+    second.emplace(2, "two");
+
+    auto rejected = first.insert(second.extract(1));
+    check(!rejected.inserted, "unequal allocators, existing key");
+    check(!rejected.node.empty() && rejected.node.mapped() == "second", "node keeps its value");
+    check(first.find(1)->second == "first", "existing value is kept");
+
+    auto inserted = first.insert(second.extract(2));
+    check(inserted.inserted && inserted.node.empty(), "unequal allocators, new key");
+    check(first.find(2)->second == "two" && second.size() == 0, "value moved across allocators");
+}
+
+void test_move_unequal_allocators() {
+    std::pmr::unsynchronized_pool_resource target_resource;
+    pmr::UnorderedMap<int, std::unique_ptr<std::string>> target(&target_resource);
+    target.emplace(-1, std::make_unique<std::string>("old"));
+    {
+        std::pmr::unsynchronized_pool_resource source_resource;
+        pmr::UnorderedMap<int, std::unique_ptr<std::string>> source(&source_resource);
+        for (int i = 0; i < 200; ++i) {
+            source.emplace(i, std::make_unique<std::string>(std::to_string(i)));
+        }
+        target = std::move(source);
+        check(source.size() == 0 && source.begin() == source.end(), "moved-from map is cleared");
+        source.emplace(1, std::make_unique<std::string>("reused"));
+        check(source.size() == 1, "moved-from map is usable");
+    }
+    // the source resource is gone, so every node must live in the target resource
+    check(target.size() == 200 && target.find(-1) == target.end(), "move replaces the contents");
+    for (int i = 0; i < 200; ++i) {
+        check(*target.find(i)->second == std::to_string(i), "elements are moved across allocators");
+    }
+    target.emplace(500, std::make_unique<std::string>("500"));
+    check(target.size() == 201, "map stays usable after the move");
+}
+
+void test_defragment() {
+    UnorderedMap<int, std::string, std::hash<int>, std::equal_to<int>,
+            FastAllocator<std::pair<const int, std::string>>> map;
+    std::unordered_map<int, std::string> expected;
+    for (int i = 0; i < 300; ++i) {
+        map.emplace(i, std::to_string(i));
+        expected.emplace(i, std::to_string(i));
+    }
+    for (int i = 0; i < 300; i += 3) {
+        map.erase(map.find(i));
+        expected.erase(i);
+    }
+    map.defragment();
+    check(same(map, expected), "defragment keeps the contents");
+    for (auto& item : expected) {
+        check(map.find(item.first) != map.end(), "buckets are rebuilt after defragment");
+    }
+}
+
+void test_merge() {
+    UnorderedMap<int, std::string> first;
+    UnorderedMap<int, std::string> second;
+    std::unordered_map<int, std::string> expected;
+    for (int i = 0; i < 100; ++i) {
+        first.emplace(i, "first");
+        expected.emplace(i, "first");
+    }
+    for (int i = 50; i < 150; ++i) {
+        second.emplace(i, "second");
+        expected.emplace(i, "second");
+    }
+    first.merge(second);
+    check(same(first, expected), "merge contents");
+    check(second.size() == 50, "merge leaves duplicates in the source");
+}
+
+int main() {
+    test_against_std();
+    test_node_handles();
+    test_node_rekey();
+    test_node_handles_unequal_allocators();
+    test_move_unequal_allocators();
+    test_defragment();
+    test_merge();
+    std::cout << "unordered_map_test: ok" << std::endl;
+    return 0;
+}